@@ -0,0 +1,220 @@
+//
+// Perft benchmark over the standard positions from the chess programming wiki.
+//
+// usage: perft_bench [--depth N] [--threads N] [--split N] [--hash MB]
+//                    [--position NAME]... [--json PATH] [--label TEXT]
+//
+
+#include <ChessGame.h>
+#include <Perft.h>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <format>
+
+namespace {
+  constexpr std::string_view usage =
+    "usage: perft_bench [--depth N] [--threads N] [--split N] [--hash MB] [--position NAME]... [--json PATH] "
+    "[--label TEXT]\n";
+
+  struct BenchPosition {
+    std::string_view name;
+    std::string_view fen;
+    // expected[d - 1] is the node count at depth d
+    std::vector<uint64_t> expected;
+  };
+
+  const std::vector<BenchPosition> positions = {
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+      {20, 400, 8902, 197281, 4865609, 119060324, 3195901860}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      {48, 2039, 97862, 4085603, 193690690, 8031647685}},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+      {14, 191, 2812, 43238, 674624, 11030083, 178633661}},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+      {6, 264, 9467, 422333, 15833292, 706045033}},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+      {44, 1486, 62379, 2103487, 89941194}},
+    {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+      {46, 2079, 89890, 3894594, 164075551, 6923051137}},
+  };
+
+  struct Options {
+    int depth{5};
+    size_t threads{1};
+    int split_ply{2};
+    size_t hash_mb{0};
+    std::vector<std::string> only;
+    std::string json_path;
+    std::string label;
+  };
+
+  struct DepthResult {
+    int depth;
+    uint64_t nodes;
+    uint64_t expected;
+    double seconds;
+  };
+
+  struct PositionResult {
+    const BenchPosition* position;
+    std::vector<DepthResult> depths;
+  };
+
+  double nps(uint64_t nodes, double seconds) {
+    return seconds > 0 ? nodes / seconds : 0;
+  }
+
+  uint64_t run_perft(const ChessGame& game, int depth, const Options& opts) {
+    if (opts.threads > 1) {
+      return parallel_perft(game, depth, opts.threads, opts.split_ply, opts.hash_mb);
+    }
+    ChessGame g(game);
+    if (opts.hash_mb) {
+      PerftCache cache(opts.hash_mb);
+      return perft(g, depth, &cache);
+    }
+    return perft(g, depth);
+  }
+
+  std::string json_escape(std::string_view s) {
+    std::string out;
+    for (const char c : s) {
+      if (c == '"' || c == '\\') {
+        out += '\\';
+      }
+      out += c;
+    }
+    return out;
+  }
+
+  void write_json(std::ostream& out, const Options& opts, const std::vector<PositionResult>& results,
+                  uint64_t total_nodes, double total_seconds, bool ok) {
+    out << "{\n";
+    out << std::format("  \"label\": \"{}\",\n", json_escape(opts.label));
+    out << std::format("  \"threads\": {},\n  \"split_ply\": {},\n  \"hash_mb\": {},\n  \"max_depth\": {},\n",
+      opts.threads, opts.split_ply, opts.hash_mb, opts.depth);
+    out << "  \"positions\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+      const auto& [position, depths] = results[i];
+      out << std::format("    {{\"name\": \"{}\", \"fen\": \"{}\", \"depths\": [\n",
+        position->name, position->fen);
+      for (size_t d = 0; d < depths.size(); ++d) {
+        const DepthResult& r = depths[d];
+        out << std::format("      {{\"depth\": {}, \"nodes\": {}, \"expected\": {}, \"ok\": {}, "
+                           "\"seconds\": {:.6f}, \"nps\": {:.0f}}}{}\n",
+          r.depth, r.nodes, r.expected, r.nodes == r.expected, r.seconds, nps(r.nodes, r.seconds),
+          d + 1 < depths.size() ? "," : "");
+      }
+      out << "    ]}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n";
+    out << std::format("  \"total_nodes\": {},\n  \"total_seconds\": {:.6f},\n  \"nps\": {:.0f},\n  \"ok\": {}\n",
+      total_nodes, total_seconds, nps(total_nodes, total_seconds), ok);
+    out << "}\n";
+  }
+
+  // Leaves value alone unless all of s is a number that fits
+  template <typename T>
+  bool parse_number(std::string_view s, T& value) {
+    T parsed{};
+    const auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), parsed);
+    if (s.empty() || ec != std::errc{} || ptr != s.data() + s.size()) {
+      return false;
+    }
+    value = parsed;
+    return true;
+  }
+
+  bool parse_args(int argc, char** argv, Options& opts) {
+    for (int i = 1; i < argc; ++i) {
+      const std::string_view arg = argv[i];
+      if (i + 1 >= argc) {
+        std::cerr << "missing value for " << arg << "\n";
+        return false;
+      }
+      const std::string value = argv[++i];
+      if (arg == "--depth") {
+        if (!parse_number(value, opts.depth)) {
+          std::cerr << "invalid depth " << value << "\n";
+          return false;
+        }
+      } else if (arg == "--threads") {
+        if (!parse_number(value, opts.threads)) {
+          std::cerr << "invalid thread count " << value << "\n";
+          return false;
+        }
+      } else if (arg == "--split") {
+        if (!parse_number(value, opts.split_ply)) {
+          std::cerr << "invalid split ply " << value << "\n";
+          return false;
+        }
+      } else if (arg == "--hash") {
+        if (!parse_number(value, opts.hash_mb)) {
+          std::cerr << "invalid hash size " << value << "\n";
+          return false;
+        }
+      } else if (arg == "--position") {
+        opts.only.push_back(value);
+      } else if (arg == "--json") {
+        opts.json_path = value;
+      } else if (arg == "--label") {
+        opts.label = value;
+      } else {
+        std::cerr << "unknown option " << arg << "\n";
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+int main(int argc, char** argv) {
+  Options opts;
+  if (!parse_args(argc, argv, opts)) {
+    std::cerr << usage;
+    return 2;
+  }
+
+  std::vector<PositionResult> results;
+  uint64_t total_nodes{};
+  double total_seconds{};
+  bool ok = true;
+
+  for (const BenchPosition& position : positions) {
+    if (!opts.only.empty() && std::ranges::find(opts.only, position.name) == opts.only.end()) {
+      continue;
+    }
+    const ChessGame game{position.fen};
+    PositionResult& result = results.emplace_back(PositionResult{&position, {}});
+    const int max_depth = std::min<int>(opts.depth, position.expected.size());
+    std::cout << std::format("{:<10} {:>5} {:>14} {:>10} {:>14}\n", position.name, "depth", "nodes", "ms", "nps");
+    for (int depth = 1; depth <= max_depth; ++depth) {
+      const auto start = std::chrono::steady_clock::now();
+      const uint64_t nodes = run_perft(game, depth, opts);
+      const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      const uint64_t expected = position.expected[depth - 1];
+      result.depths.push_back({depth, nodes, expected, seconds});
+      total_nodes += nodes;
+      total_seconds += seconds;
+      ok = ok && nodes == expected;
+      std::cout << std::format("{:<10} {:>5} {:>14} {:>10.1f} {:>14.0f}{}\n", "", depth, nodes,
+        seconds * 1000, nps(nodes, seconds), nodes == expected ? "" : std::format("  MISMATCH, expected {}", expected));
+    }
+  }
+
+  std::cout << std::format("total nodes {} in {:.3f}s, {:.0f} nps, {}\n",
+    total_nodes, total_seconds, nps(total_nodes, total_seconds), ok ? "all counts match" : "COUNT MISMATCH");
+
+  if (!opts.json_path.empty()) {
+    std::ofstream out(opts.json_path);
+    write_json(out, opts, results, total_nodes, total_seconds, ok);
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+//
+// Lazy SMP scaling benchmark: fixed depth searches over a set of positions, repeated
+// for each thread count, reporting time to depth, NPS and speedup over the first count.
+//
+// usage: search_bench [--depth N] [--threads N,N,...] [--hash MB]
+//                     [--position NAME]... [--json PATH] [--label TEXT]
+//
+
+#include <ChessGame.h>
+#include <ParallelSearch.h>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <format>
+
+namespace {
+  constexpr std::string_view usage =
+    "usage: search_bench [--depth N] [--threads N,N,...] [--hash MB] [--position NAME]... [--json PATH] "
+    "[--label TEXT]\n";
+
+  struct BenchPosition {
+    std::string_view name;
+    std::string_view fen;
+  };
+
+  const std::vector<BenchPosition> positions = {
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"},
+    {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"},
+  };
+
+  struct Options {
+    int depth{7};
+    std::vector<size_t> threads{1};
+    size_t hash_mb{64};
+    std::vector<std::string> only;
+    std::string json_path;
+    std::string label;
+  };
+
+  struct PositionResult {
+    const BenchPosition* position;
+    std::string best_move;
+    int score;
+    uint64_t nodes;
+    double seconds;
+  };
+
+  struct ThreadResult {
+    size_t threads;
+    std::vector<PositionResult> positions;
+    uint64_t nodes{};
+    double seconds{};
+  };
+
+  double nps(uint64_t nodes, double seconds) {
+    return seconds > 0 ? nodes / seconds : 0;
+  }
+
+  std::string json_escape(std::string_view s) {
+    std::string out;
+    for (const char c : s) {
+      if (c == '"' || c == '\\') {
+        out += '\\';
+      }
+      out += c;
+    }
+    return out;
+  }
+
+  void write_json(std::ostream& out, const Options& opts, const std::vector<ThreadResult>& results) {
+    out << "{\n";
+    out << std::format("  \"label\": \"{}\",\n", json_escape(opts.label));
+    out << std::format("  \"depth\": {},\n  \"hash_mb\": {},\n", opts.depth, opts.hash_mb);
+    out << "  \"runs\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+      const ThreadResult& run = results[i];
+      out << std::format("    {{\"threads\": {}, \"nodes\": {}, \"seconds\": {:.6f}, \"nps\": {:.0f}, "
+                         "\"speedup\": {:.3f}, \"positions\": [\n",
+        run.threads, run.nodes, run.seconds, nps(run.nodes, run.seconds),
+        run.seconds > 0 ? results.front().seconds / run.seconds : 0);
+      for (size_t p = 0; p < run.positions.size(); ++p) {
+        const PositionResult& r = run.positions[p];
+        out << std::format("      {{\"name\": \"{}\", \"best_move\": \"{}\", \"score\": {}, \"nodes\": {}, "
+                           "\"seconds\": {:.6f}, \"nps\": {:.0f}}}{}\n",
+          r.position->name, r.best_move, r.score, r.nodes, r.seconds, nps(r.nodes, r.seconds),
+          p + 1 < run.positions.size() ? "," : "");
+      }
+      out << "    ]}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+  }
+
+  // Leaves value alone unless all of s is a number that fits
+  template <typename T>
+  bool parse_number(std::string_view s, T& value) {
+    T parsed{};
+    const auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), parsed);
+    if (s.empty() || ec != std::errc{} || ptr != s.data() + s.size()) {
+      return false;
+    }
+    value = parsed;
+    return true;
+  }
+
+  bool parse_args(int argc, char** argv, Options& opts) {
+    for (int i = 1; i < argc; ++i) {
+      const std::string_view arg = argv[i];
+      if (i + 1 >= argc) {
+        std::cerr << "missing value for " << arg << "\n";
+        return false;
+      }
+      const std::string value = argv[++i];
+      if (arg == "--depth") {
+        if (!parse_number(value, opts.depth)) {
+          std::cerr << "invalid depth " << value << "\n";
+          return false;
+        }
+      } else if (arg == "--threads") {
+        opts.threads.clear();
+        std::stringstream list(value);
+        for (std::string count; std::getline(list, count, ',');) {
+          size_t threads{};
+          if (!parse_number(count, threads)) {
+            std::cerr << "invalid thread count " << count << "\n";
+            return false;
+          }
+          opts.threads.push_back(std::max<size_t>(1, threads));
+        }
+      } else if (arg == "--hash") {
+        if (!parse_number(value, opts.hash_mb)) {
+          std::cerr << "invalid hash size " << value << "\n";
+          return false;
+        }
+      } else if (arg == "--position") {
+        opts.only.push_back(value);
+      } else if (arg == "--json") {
+        opts.json_path = value;
+      } else if (arg == "--label") {
+        opts.label = value;
+      } else {
+        std::cerr << "unknown option " << arg << "\n";
+        return false;
+      }
+    }
+    return !opts.threads.empty();
+  }
+}
+
+int main(int argc, char** argv) {
+  Options opts;
+  if (!parse_args(argc, argv, opts)) {
+    std::cerr << usage;
+    return 2;
+  }
+
+  TranspositionTable tt(opts.hash_mb);
+  std::vector<ThreadResult> results;
+  SearchLimits limits;
+  limits.depth = opts.depth;
+
+  for (const size_t threads : opts.threads) {
+    ParallelSearch search(tt, threads);
+    ThreadResult& run = results.emplace_back(ThreadResult{threads, {}});
+    std::cout << std::format("{:>2} threads {:<10} {:>6} {:>6} {:>14} {:>10} {:>14} {:>9}\n",
+      threads, "", "move", "score", "nodes", "ms", "nps", "pawn hit");
+    for (const BenchPosition& position : positions) {
+      if (!opts.only.empty() && std::ranges::find(opts.only, position.name) == opts.only.end()) {
+        continue;
+      }
+      // Every search starts cold so thread counts are compared on equal terms
+      tt.clear();
+      const ChessGame game{position.fen};
+      const auto start = std::chrono::steady_clock::now();
+      const SearchResult result = search.run(game, limits);
+      const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      run.positions.push_back({&position, result.best_move.to_string(), result.score, result.nodes, seconds});
+      run.nodes += result.nodes;
+      run.seconds += seconds;
+      std::cout << std::format("{:>10} {:<10} {:>6} {:>6} {:>14} {:>10.1f} {:>14.0f} {:>8.1f}%\n", "", position.name,
+        result.best_move.to_string(), result.score, result.nodes, seconds * 1000, nps(result.nodes, seconds),
+        search.pawn_stats().hit_rate() * 100);
+    }
+  }
+
+  std::cout << std::format("\n{:>7} {:>14} {:>10} {:>14} {:>8}\n", "threads", "nodes", "ms", "nps", "speedup");
+  for (const ThreadResult& run : results) {
+    std::cout << std::format("{:>7} {:>14} {:>10.1f} {:>14.0f} {:>8.2f}\n", run.threads, run.nodes,
+      run.seconds * 1000, nps(run.nodes, run.seconds), run.seconds > 0 ? results.front().seconds / run.seconds : 0);
+  }
+
+  if (!opts.json_path.empty()) {
+    std::ofstream out(opts.json_path);
+    write_json(out, opts, results);
+  }
+  return 0;
+}
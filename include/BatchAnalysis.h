@@ -0,0 +1,60 @@
+#ifndef BATCHANALYSIS_H
+#define BATCHANALYSIS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+/*
+ * Streaming analysis of EPD or FEN files. A reader stage splits the input into chunks
+ * of lines, a thread pool parses each line into a position and runs the requested
+ * operation, and a writer stage emits the results in input order. At most a fixed
+ * number of chunks are read but not yet written, so memory stays flat however large
+ * the input is.
+ */
+
+enum class BatchOperation {
+  LegalMoves,
+  Perft,
+  Evaluate
+};
+
+struct BatchOptions {
+  BatchOperation operation{BatchOperation::LegalMoves};
+  // Perft depth, ignored by the other operations
+  int depth{1};
+  size_t threads{1};
+  size_t chunk_lines{256};
+  size_t max_chunks_in_flight{64};
+};
+
+struct BatchStats {
+  uint64_t positions{};
+  uint64_t errors{};
+  std::chrono::duration<double> elapsed{};
+
+  double positions_per_second() const {
+    return elapsed.count() > 0 ? static_cast<double>(positions) / elapsed.count() : 0.0;
+  }
+};
+
+/**
+ * Converts an EPD record or a FEN to a six field FEN. EPD operations after the four
+ * position fields are dropped except hmvc and fmvn, which supply the clocks.
+ * @param error Set to a description when the line is not a valid position
+ * @return The FEN, or an empty string when error was set
+ */
+std::string epd_to_fen(std::string_view line, std::string& error);
+
+/**
+ * Reads one position per line from in and writes "line<TAB>result" for each to out,
+ * in input order. Blank lines and lines starting with '#' are skipped. The result is
+ * the legal move count, the perft count or the static evaluation in centipawns from
+ * the side to move's view, or "error: ..." for a line that does not parse.
+ */
+BatchStats analyse_batch(std::istream& in, std::ostream& out, const BatchOptions& options);
+
+#endif
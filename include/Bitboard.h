@@ -0,0 +1,160 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * A set of squares, one bit per square. Bit 0 is a1, bit 7 is h1 and bit 63 is h8,
+ * so a square's index is rank * 8 + file.
+ */
+using Bitboard = uint64_t;
+
+constexpr Bitboard FileABB = 0x0101010101010101ULL;
+constexpr Bitboard FileHBB = FileABB << 7;
+constexpr Bitboard Rank1BB = 0xFFULL;
+constexpr Bitboard Rank8BB = Rank1BB << 56;
+constexpr Bitboard Rank2BB = Rank1BB << 8;
+constexpr Bitboard Rank7BB = Rank1BB << 48;
+
+constexpr Bitboard square_bb(int sq) {
+  return 1ULL << sq;
+}
+
+inline int popcount(Bitboard b) {
+  return std::popcount(b);
+}
+
+/**
+ * @return index of the least significant set bit, b must not be empty
+ */
+inline int lsb(Bitboard b) {
+  return std::countr_zero(b);
+}
+
+/**
+ * Removes the least significant set bit from b and returns its index
+ */
+inline int pop_lsb(Bitboard& b) {
+  const int sq = lsb(b);
+  b &= b - 1;
+  return sq;
+}
+
+namespace Bitboards {
+  using Offsets = std::array<std::array<int, 2>, 8>;
+
+  constexpr Offsets knight_offsets = {{{1, 2}, {1, -2}, {2, 1}, {2, -1}, {-1, 2}, {-1, -2}, {-2, 1}, {-2, -1}}};
+  constexpr Offsets king_offsets = {{{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}}};
+
+  constexpr std::array<Bitboard, 64> leaper_table(const Offsets& offsets, size_t count) {
+    std::array<Bitboard, 64> table{};
+    for (int sq = 0; sq < 64; ++sq) {
+      for (size_t i = 0; i < count; ++i) {
+        const int rank = (sq >> 3) + offsets[i][0];
+        const int file = (sq & 7) + offsets[i][1];
+        if (rank >= 0 && rank < 8 && file >= 0 && file < 8) {
+          table[sq] |= square_bb(rank * 8 + file);
+        }
+      }
+    }
+    return table;
+  }
+
+  constexpr std::array<Bitboard, 64> knight_table = leaper_table(knight_offsets, 8);
+  constexpr std::array<Bitboard, 64> king_table = leaper_table(king_offsets, 8);
+  // Index 0 holds the squares a white pawn attacks, index 1 a black pawn
+  constexpr std::array<std::array<Bitboard, 64>, 2> pawn_table = {
+    leaper_table({{{1, -1}, {1, 1}}}, 2),
+    leaper_table({{{-1, -1}, {-1, 1}}}, 2)
+  };
+}
+
+constexpr Bitboard knight_attacks(int sq) {
+  return Bitboards::knight_table[sq];
+}
+
+constexpr Bitboard king_attacks(int sq) {
+  return Bitboards::king_table[sq];
+}
+
+/**
+ * @param side 0 for a white pawn, 1 for a black pawn
+ */
+constexpr Bitboard pawn_attacks(int side, int sq) {
+  return Bitboards::pawn_table[side][sq];
+}
+
+/**
+ * Fancy magic lookup for one square: the relevant occupancy bits are multiplied by
+ * the magic number and the top bits of the product index that square's attack slice.
+ */
+struct Magic {
+  Bitboard mask;
+  Bitboard magic;
+  Bitboard* attacks;
+  unsigned shift;
+
+  unsigned index(Bitboard occupied) const {
+    return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+  }
+};
+
+namespace Bitboards {
+  struct Tables {
+    std::array<Magic, 64> bishop_magics;
+    std::array<Magic, 64> rook_magics;
+    std::array<std::array<Bitboard, 64>, 64> between;
+    std::array<std::array<Bitboard, 64>, 64> line;
+  };
+
+  /**
+   * Builds the slider and line tables, only ever called once by tables()
+   */
+  const Tables& build_tables();
+
+  /**
+   * @return The slider and line tables, built on first use so static initializers in
+   * other translation units can use the attack functions too
+   */
+  inline const Tables& tables() {
+    static const Tables& built = build_tables();
+    return built;
+  }
+}
+
+/**
+ * @return squares strictly between a and b when they share a rank, file or diagonal, otherwise empty
+ */
+inline Bitboard between_bb(int a, int b) {
+  return Bitboards::tables().between[a][b];
+}
+
+/**
+ * @return the full board line through a and b, including both, or empty when they are not aligned
+ */
+inline Bitboard line_bb(int a, int b) {
+  return Bitboards::tables().line[a][b];
+}
+
+inline bool aligned(int a, int b, int c) {
+  return line_bb(a, b) & square_bb(c);
+}
+
+inline Bitboard bishop_attacks(int sq, Bitboard occupied) {
+  const Magic& m = Bitboards::tables().bishop_magics[sq];
+  return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard rook_attacks(int sq, Bitboard occupied) {
+  const Magic& m = Bitboards::tables().rook_magics[sq];
+  return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queen_attacks(int sq, Bitboard occupied) {
+  return bishop_attacks(sq, occupied) | rook_attacks(sq, occupied);
+}
+
+#endif
@@ -1,9 +1,17 @@
 #ifndef CHESSGAME_H
 #define CHESSGAME_H
 #include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <vector>
+#include <Fen.h>
 #include <GameTypes.h>
+#include <Kpk.h>
 #include <MoveGenerator.h>
+#include <Nnue.h>
+#include <PawnTable.h>
+#include <PositionSnapshot.h>
 
 
 
@@ -21,28 +29,129 @@ public:
     bool passant_sqr_exists{false};
     size_t half_move_clock{};
     size_t full_moves{1};
+    uint64_t key{};
   };
 
   ChessGame();
-  explicit ChessGame(const std::string& fen);
-
-  ChessGame(ChessGame&&) = default;
+  /**
+   * Boards without a king on each side are accepted so tests can set up partial
+   * positions, but search and move generation assume legal ones. Callers taking
+   * positions from users must check for one king a side and that the side not to move
+   * is not in check, as the UCI front end and batch analysis do.
+   * @throws std::runtime_error if fen does not parse, see Fen.h
+   */
+  explicit ChessGame(std::string_view fen);
+  explicit ChessGame(const Fen::Position& position);
+  explicit ChessGame(const PositionSnapshot& position);
+
+  // The move generator refers to this game's own board, so copies and moves rebind it
+  ChessGame(ChessGame&& other) noexcept;
+  ChessGame(const ChessGame& other);
   ~ChessGame() = default;
   ChessGame& operator=(ChessGame&&) = delete;
-  ChessGame(const ChessGame&) = delete;
   ChessGame& operator=(const ChessGame&) = delete;
 
   void apply_move(Move move);
+  void apply_move(PackedMove move);
   std::vector<Move> generate_legal_moves(Piece p, Square s);
+
+  /**
+   * Fills list with every legal move for the side to move. Legality comes from the
+   * checkers and pinned pieces of the current position, no move is made on the board.
+   */
+  void generate_legal_moves(MoveList& list);
   const std::vector<std::pair<Piece, Square>>& get_piece_list();
+  /**
+   * @return Whether s is attacked by the side not to move
+   */
   bool is_check(Square s) const;
+
+  /**
+   * @return Every square attacked by a piece of color by
+   */
+  Bitboard attacked_squares(Color by) const;
   void undo_move();
   Color get_current_turn() const;
 
+  /**
+   * @return Zobrist key covering piece placement, side to move, castling rights and
+   * the en passant file. Maintained incrementally by apply_move and undo_move.
+   */
+  uint64_t key() const { return state.key; }
+
+  /**
+   * @return The position's Zobrist key computed from scratch
+   */
+  uint64_t compute_key() const;
+
+  /**
+   * @return A trivially copyable copy of the current position, without move history
+   */
+  PositionSnapshot snapshot() const;
+
   GameState get_state() {
     return state;
   }
 
+  const GameBoard& get_board() const {
+    return board;
+  }
+
+  /**
+   * @return FEN of the current position with all six fields
+   */
+  std::string to_fen() const;
+
+  /**
+   * @return Bitmask of the CastlingRight values still available
+   */
+  uint8_t castling_rights() const;
+
+  /**
+   * @return Square a pawn may capture en passant onto, if the last move allows one
+   */
+  std::optional<Square> en_passant_square() const;
+
+  /**
+   * @return Static exchange value in centipawns of a legal move, see See.h
+   */
+  int see(PackedMove m) const;
+
+  /**
+   * @return Whether the static exchange value of a legal move is at least threshold
+   */
+  bool see_ge(PackedMove m, int threshold = 0) const;
+
+  /**
+   * @return Whether the side to move is in check
+   */
+  bool in_check() const;
+
+  /**
+   * @return Whether the fifty move rule applies or the position occurred before with
+   * the same side to move since the last capture or pawn move
+   */
+  bool is_draw() const;
+
+  /**
+   * Evaluates with network from now on, or with the board's classical evaluation when
+   * null. The accumulators are rebuilt here and then follow apply_move and undo_move.
+   */
+  void set_network(const Nnue::Network* network);
+
+  /**
+   * @param pawns Cache for the classical evaluation's pawn structure terms, which are
+   * left out without one. Unused when a network is set.
+   * @return Static evaluation in centipawns from the side to move's point of view
+   */
+  int evaluate(PawnTable* pawns = nullptr) const;
+
+  /**
+   * @return Whether the side with the pawn wins, or nullopt unless only two kings and
+   * one pawn are left, see Kpk.h
+   */
+  std::optional<bool> probe_kpk() const { return Kpk::probe(board, state.current_turn); }
+
   void set_state(GameState& s) {
     state = s;
   }
@@ -57,20 +166,34 @@ private:
   bool can_promote(Piece pos, Square s) const;
   void update_en_passant_square(Square last_pawn_move, Color pawn_color);
 
-  void set_castling_from_fen(std::string_view f);
   bool can_k_side_castle(Square king_pos);
   bool can_q_side_castle(Square king_pos);
 
   void update_castling_rights(Piece p,Square source);
+  uint64_t castling_and_en_passant_key() const;
+  void verify_key() const;
   std::vector<Move> get_castling_squares(Square king_pos);
   std::array<Move, 4> get_promotion_moves(Square from, Square to);
-  Move get_rook_castle_move(const Move &move);
+  Move get_rook_castle_move(const Move &move) const;
+
+  // Squares a move may change and what stood on them before it, for the accumulator update
+  struct DirtySquares {
+    std::array<int, 4> squares{};
+    std::array<Piece, 4> before{};
+    size_t count{};
+  };
+  DirtySquares dirty_squares(const Move& move) const;
+  void push_accumulator(const DirtySquares& dirty, Piece moved);
 
   GameState state;
-  std::vector<Move> move_history;
-  std::vector<Position>& piece_list;
+  std::vector<PackedMove> move_history;
   std::vector<GameState> prev_state;
 
+  const Nnue::Network* network{};
+  // One entry per ply since set_network, the back is the current position. Undoing a
+  // move made before set_network rebuilds the last entry instead of popping it
+  std::vector<Nnue::Accumulator> accumulators;
+
 };
 
 
@@ -0,0 +1,147 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+/*
+ * Tapered evaluation terms. Every piece contributes a middlegame and an endgame value,
+ * material plus a piece-square bonus, and a phase weight. Boards keep the sums current
+ * as pieces are placed and removed, so evaluating a position costs a blend of two
+ * numbers instead of a walk over the pieces.
+ */
+namespace Eval {
+  struct Score {
+    int mg{};
+    int eg{};
+
+    constexpr Score& operator+=(Score o) { mg += o.mg; eg += o.eg; return *this; }
+    constexpr Score& operator-=(Score o) { mg -= o.mg; eg -= o.eg; return *this; }
+    constexpr Score operator-() const { return {-mg, -eg}; }
+    constexpr bool operator==(const Score&) const = default;
+  };
+
+  // Phase is the sum of these weights over the pieces on the board, 24 at the start
+  constexpr int max_phase = 24;
+  constexpr std::array<int, 7> phase_weight = {0, 0, 1, 1, 2, 4, 0};
+
+  constexpr std::array<Score, 7> material = {{{0, 0}, {82, 94}, {337, 281}, {365, 297}, {477, 512}, {1025, 936}, {0, 0}}};
+
+  using Table = std::array<int, 64>;
+
+  // Piece-square bonuses for white as printed on a diagram, a8 first and h1 last
+  constexpr Table pawn_mg = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+  };
+  constexpr Table pawn_eg = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     80,  80,  80,  80,  80,  80,  80,  80,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     30,  30,  30,  30,  30,  30,  30,  30,
+     15,  15,  15,  15,  15,  15,  15,  15,
+      5,   5,   5,   5,   5,   5,   5,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+  };
+  constexpr Table knight = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50,
+  };
+  constexpr Table bishop = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20,
+  };
+  constexpr Table rook = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0,
+  };
+  constexpr Table queen = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+  };
+  constexpr Table king_mg = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20,
+  };
+  constexpr Table king_eg = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50,
+  };
+
+  /**
+   * Material plus piece-square value of every piece on every square, indexed like the
+   * board's piece bitboards (white pawn through king, then black). Black entries are
+   * mirrored and negated, so summing over the board gives white's advantage.
+   */
+  constexpr std::array<std::array<Score, 64>, 12> make_psqt() {
+    constexpr std::array<const Table*, 7> mg = {nullptr, &pawn_mg, &knight, &bishop, &rook, &queen, &king_mg};
+    constexpr std::array<const Table*, 7> eg = {nullptr, &pawn_eg, &knight, &bishop, &rook, &queen, &king_eg};
+    std::array<std::array<Score, 64>, 12> psqt{};
+    for (int t = 1; t <= 6; ++t) {
+      for (int sq = 0; sq < 64; ++sq) {
+        // The tables start at a8, so a white piece on sq reads row 7 - rank
+        const Score white = {material[t].mg + (*mg[t])[sq ^ 56], material[t].eg + (*eg[t])[sq ^ 56]};
+        const Score black = {material[t].mg + (*mg[t])[sq], material[t].eg + (*eg[t])[sq]};
+        psqt[t - 1][sq] = white;
+        psqt[t + 5][sq] = -black;
+      }
+    }
+    return psqt;
+  }
+
+  inline constexpr std::array<std::array<Score, 64>, 12> psqt = make_psqt();
+
+  /**
+   * @return Blend of s weighted by phase, from pure middlegame at max_phase to pure endgame at 0
+   */
+  constexpr int taper(Score s, int phase) {
+    phase = std::min(phase, max_phase);
+    return (s.mg * phase + s.eg * (max_phase - phase)) / max_phase;
+  }
+}
+
+#endif
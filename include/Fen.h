@@ -0,0 +1,72 @@
+#ifndef FEN_H
+#define FEN_H
+
+#include <GameTypes.h>
+#include <array>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/*
+ * Forsyth-Edwards Notation. Parsing reads straight from a string_view without
+ * allocating, throwing or printing, so bulk position ingest costs no more than the
+ * characters it scans. Fields may be separated by any run of spaces or tabs, and the
+ * half move clock and full move number may both be left out, defaulting to 0 and 1.
+ *
+ * Only the notation is checked, not whether the position could arise in a game: a
+ * board without kings parses, since tests and tools set up partial positions. Pawns
+ * on rank 1 or 8 are refused, move generation relies on there being none. Rights
+ * the board cannot back are dropped rather than rejected: castling needs the king and
+ * rook on their home squares, and an en passant square is kept only on the side to
+ * move's capture rank with the enemy pawn that just pushed in front of it.
+ */
+namespace Fen {
+  enum class Error : uint8_t {
+    MissingField,
+    PiecePlacement,
+    SideToMove,
+    Castling,
+    EnPassant,
+    HalfMoveClock,
+    FullMoveNumber,
+    TrailingInput
+  };
+
+  /**
+   * @return Short description of error for messages, such as "castling field must be
+   * - or a subset of KQkq"
+   */
+  std::string_view message(Error error);
+
+  // Empty squares hold {NoPiece, NoColor}, indexed like the bitboards with a1 = 0
+  using Squares = std::array<Piece, 64>;
+
+  struct Position {
+    Squares squares{};
+    Color side_to_move{White};
+    // Bitmask of CastlingRight values
+    uint8_t castling_rights{};
+    std::optional<Square> en_passant;
+    uint16_t half_move_clock{};
+    uint16_t full_moves{1};
+  };
+
+  /**
+   * @return The position, or the first field found to be malformed
+   */
+  std::expected<Position, Error> parse(std::string_view fen);
+
+  /**
+   * Reads the piece placement field alone, eight ranks of eight squares from rank 8 down
+   */
+  std::expected<Squares, Error> parse_placement(std::string_view placement);
+
+  /**
+   * @return All six fields of position, the inverse of parse
+   */
+  std::string to_string(const Position& position);
+}
+
+#endif
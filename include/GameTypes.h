@@ -1,6 +1,7 @@
 #ifndef GAMETYPES_H
 #define GAMETYPES_H
 
+#include <cassert>
 #include <cstdint>
 #include <utility>
 #include <vector>
@@ -8,19 +9,33 @@
 #include <array>
 #include <iostream>
 #include <sstream>
+#include <string_view>
 #include <__format/format_functions.h>
+#include <Bitboard.h>
+#include <Zobrist.h>
+#include <Evaluation.h>
 
-using Board = std::array<std::array<u_int8_t, 8>, 8>;
+using Board = std::array<u_int8_t, 64>;
 
 
 enum PieceType : uint8_t {
   NoPiece, Pawn, Knight, Bishop, Rook, Queen, King
 };
 
+/**
+ * Material in centipawns by PieceType, used to order and weigh captures. The king has
+ * no exchange value since it is never captured.
+ */
+constexpr std::array<int, 7> piece_value = {0, 100, 320, 330, 500, 900, 0};
+
 enum Color : uint8_t {
   NoColor = 0, White = 8, Black = 16
 };
 
+enum CastlingRight : uint8_t {
+  WhiteKingSide = 1, WhiteQueenSide = 2, BlackKingSide = 4, BlackQueenSide = 8
+};
+
 enum Rank {
   Rank_1, Rank_2, Rank_3, Rank_4, Rank_5, Rank_6, Rank_7, Rank_8
 };
@@ -69,6 +84,14 @@ struct Square {
   }
 };
 
+constexpr int to_index(Square s) {
+  return s.rank * 8 + s.file;
+}
+
+constexpr Square to_square(int idx) {
+  return {static_cast<Rank>(idx >> 3), static_cast<File>(idx & 7)};
+}
+
 struct MoveDir {
   int to_rank;
   int to_file;
@@ -93,8 +116,133 @@ struct Move {
   }
 };
 
+/**
+ * Four bit move kind stored in a PackedMove. Bit 2 marks a capture and bit 3 a
+ * promotion, whose piece is Knight + the low two bits.
+ */
+enum class MoveFlag : uint8_t {
+  Quiet = 0,
+  KingCastle = 1,
+  QueenCastle = 2,
+  Capture = 4,
+  EnPassant = 5,
+  KnightPromotion = 8,
+  BishopPromotion = 9,
+  RookPromotion = 10,
+  QueenPromotion = 11,
+  KnightPromotionCapture = 12,
+  BishopPromotionCapture = 13,
+  RookPromotionCapture = 14,
+  QueenPromotionCapture = 15
+};
+
+/**
+ * A move in 16 bits: bits 0-5 hold the from square index, bits 6-11 the to square
+ * index and bits 12-15 the MoveFlag. The all zero value is the null move.
+ */
+class PackedMove {
+public:
+  constexpr PackedMove() = default;
+
+  constexpr PackedMove(int from, int to, MoveFlag flag)
+  : data(static_cast<uint16_t>(from | (to << 6) | (static_cast<int>(flag) << 12))) {}
+
+  /**
+   * @param m Move to pack
+   * @param is_capture Whether m takes a piece on its destination, Move does not record this
+   */
+  constexpr PackedMove(const Move& m, bool is_capture)
+  : PackedMove(to_index(m.from), to_index(m.to), flag_for(m, is_capture)) {}
+
+  static constexpr PackedMove from_raw(uint16_t raw) {
+    PackedMove m;
+    m.data = raw;
+    return m;
+  }
+
+  [[nodiscard]] constexpr int from() const { return data & 0x3F; }
+  [[nodiscard]] constexpr int to() const { return (data >> 6) & 0x3F; }
+  [[nodiscard]] constexpr MoveFlag flag() const { return static_cast<MoveFlag>(data >> 12); }
+  [[nodiscard]] constexpr uint16_t raw() const { return data; }
+
+  [[nodiscard]] constexpr bool is_capture() const { return data & 0x4000; }
+  [[nodiscard]] constexpr bool is_promotion() const { return data & 0x8000; }
+  [[nodiscard]] constexpr bool is_en_passant() const { return flag() == MoveFlag::EnPassant; }
+  [[nodiscard]] constexpr bool is_castling() const {
+    return flag() == MoveFlag::KingCastle || flag() == MoveFlag::QueenCastle;
+  }
+
+  [[nodiscard]] constexpr PieceType promotion_piece() const {
+    return is_promotion() ? static_cast<PieceType>(Knight + ((data >> 12) & 0x3)) : NoPiece;
+  }
+
+  [[nodiscard]] constexpr Move to_move() const {
+    Move m{to_square(from()), to_square(to())};
+    m.is_en_passant = is_en_passant();
+    m.is_k_castle = flag() == MoveFlag::KingCastle;
+    m.is_q_castle = flag() == MoveFlag::QueenCastle;
+    m.needs_pawn_promotion = is_promotion();
+    m.promote_to = promotion_piece();
+    return m;
+  }
+
+  /**
+   * @return The move in UCI long algebraic notation, e.g. "e2e4" or "e7e8q"
+   */
+  [[nodiscard]] std::string to_string() const;
+
+  constexpr explicit operator bool() const { return data != 0; }
+  constexpr bool operator==(const PackedMove&) const = default;
+
+private:
+  static constexpr MoveFlag flag_for(const Move& m, bool is_capture) {
+    if (m.is_en_passant) return MoveFlag::EnPassant;
+    if (m.is_k_castle) return MoveFlag::KingCastle;
+    if (m.is_q_castle) return MoveFlag::QueenCastle;
+    int flag = is_capture ? static_cast<int>(MoveFlag::Capture) : static_cast<int>(MoveFlag::Quiet);
+    if (m.needs_pawn_promotion) {
+      flag |= 8 | (m.promote_to - Knight);
+    }
+    return static_cast<MoveFlag>(flag);
+  }
+
+  uint16_t data{};
+};
+
+/**
+ * Fixed capacity move buffer meant to live on the stack. No legal chess position
+ * has more than 218 moves, so 256 entries never overflow.
+ */
+class MoveList {
+public:
+  static constexpr size_t capacity = 256;
+
+  void push_back(PackedMove m) {
+    assert(count < capacity);
+    moves[count++] = m;
+  }
+
+  void clear() { count = 0; }
+  void resize(size_t n) { count = n; }
+  [[nodiscard]] size_t size() const { return count; }
+  [[nodiscard]] bool empty() const { return count == 0; }
+
+  PackedMove& operator[](size_t i) { return moves[i]; }
+  const PackedMove& operator[](size_t i) const { return moves[i]; }
+
+  PackedMove* begin() { return moves.data(); }
+  PackedMove* end() { return moves.data() + count; }
+  const PackedMove* begin() const { return moves.data(); }
+  const PackedMove* end() const { return moves.data() + count; }
+
+private:
+  std::array<PackedMove, capacity> moves;
+  size_t count{};
+};
+
 struct MoveChange {
-  Move move;
+  PackedMove move;
+  Piece moved{NoPiece, NoColor};
   Piece was_captured{NoPiece, NoColor};
   Square captured_square;
 
@@ -102,17 +250,82 @@ struct MoveChange {
 
 using Position = std::pair<Piece, Square>;
 
+/**
+ * Piece placement stored as one bitboard per piece type and color plus an occupancy
+ * bitboard per color. A square indexed mailbox mirrors the bitboards so at() is a
+ * single array load.
+ */
 class GameBoard {
   Board board{};
 public:
 
   GameBoard();
-  GameBoard(std::string fen_str);
+  /**
+   * @throws std::runtime_error if placement is not a FEN piece placement field
+   */
+  GameBoard(std::string_view placement);
   Piece at(Rank r, File f) const;
   Piece at(Square s) const;
   Piece piece_at(Square s) const;
   Position position_at(Square s);
 
+  Bitboard pieces(Color c, PieceType t) const;
+  Bitboard pieces(Color c) const;
+  Bitboard pieces(PieceType t) const;
+  Bitboard occupancy() const;
+  Square king_square(Color c) const;
+
+  /**
+   * @param sq Square index to look at
+   * @param occupied Occupancy used to block sliders, may differ from the board's own
+   * @return Pieces of both colors that attack sq
+   */
+  Bitboard attackers_to(int sq, Bitboard occupied) const;
+
+  /**
+   * @return Union of the squares attacked by every piece of color c, computed in one pass
+   */
+  Bitboard attacked_squares(Color c) const;
+
+  /**
+   * @return Zobrist key of the piece placement alone, kept current by every board change
+   */
+  uint64_t key() const { return hash; }
+
+  /**
+   * @return Zobrist key of the pawns alone, for the pawn structure cache
+   */
+  uint64_t pawn_key() const { return pawn_hash; }
+
+  /**
+   * @return Material and piece-square sum from white's view, kept current like the key
+   */
+  Eval::Score psq_score() const { return psq; }
+
+  /**
+   * @return Phase weight of the pieces on the board, Eval::max_phase or more in the opening
+   */
+  int game_phase() const { return phase; }
+
+  /**
+   * @return Tapered static evaluation from side's point of view, read from the running sums in O(1)
+   */
+  int evaluate(Color side) const {
+    const int score = Eval::taper(psq, phase);
+    return side == Black ? -score : score;
+  }
+
+  /**
+   * @return 0-5 for white pawn through king and 6-11 for black, the index of the piece's bitboard
+   */
+  static constexpr size_t piece_index(Piece p) {
+    return (p.color == Black ? 6 : 0) + p.type - 1;
+  }
+
+  static constexpr size_t color_index(Color c) {
+    return c == Black ? 1 : 0;
+  }
+
 
   bool move_piece(Piece p, Move m);
   bool undo_last_move();
@@ -124,6 +337,7 @@ public:
   std::vector<Position>& get_piece_list();
   bool set_piece(Piece p, Square s);
   bool capture_piece(Square s);
+  void clear();
 
   void print_board() const {
     std::cout << std::endl;
@@ -142,11 +356,11 @@ public:
 private:
 
   bool clear_piece(Square s);
-  void update_piece_position(Square from, Square to);
-  std::vector<std::pair<Piece, Square>> load_from_fen_piece_placement(std::string fen);
+  void load_from_fen_piece_placement(std::string_view placement);
   void set_initial_board();
   bool is_regular_capture(Piece p, Square to_squre);
 
+
   static char piece_to_fen_char(Piece p) {
     if (p.type == NoPiece) {
       return '.';
@@ -170,6 +384,14 @@ private:
     return c;
   }
 
+  std::array<Bitboard, 12> piece_bb{};
+  std::array<Bitboard, 2> color_bb{};
+  uint64_t hash{};
+  uint64_t pawn_hash{};
+  Eval::Score psq{};
+  int phase{};
+
+  // Rebuilt from the bitboards by get_piece_list(), never searched during moves
   std::vector<Position> piece_list;
   std::vector<MoveChange> move_history;
 };
@@ -0,0 +1,43 @@
+#ifndef KPK_H
+#define KPK_H
+
+#include <Bitboard.h>
+#include <GameTypes.h>
+#include <cstddef>
+#include <optional>
+
+/*
+ * King and pawn versus king bitbase. Every position with white holding a pawn on files
+ * a to d is solved by retrograde analysis the first time the bitbase is probed and kept
+ * as one bit, won or drawn, in 24 KB. Other positions are mirrored onto those, so a
+ * probe is an index computation and a bit test.
+ */
+namespace Kpk {
+  // Side to move, weak king, strong king and the 24 pawn squares on files a to d, ranks 2 to 7
+  constexpr size_t position_count = 2 * 64 * 64 * 24;
+
+  /**
+   * @param strong Color of the side with the pawn
+   * @return Whether the side with the pawn wins with best play. The position must be
+   * legal: kings apart, pawn on ranks 2 to 7 and no king in check from the side to move.
+   */
+  bool probe(Color strong, int strong_king, int pawn, int weak_king, Color side_to_move);
+
+  /**
+   * Probes a GameBoard or PositionSnapshot
+   * @return Whether the side with the pawn wins, or nullopt when the board is not
+   * exactly king and pawn versus king
+   */
+  template<typename B>
+  std::optional<bool> probe(const B& board, Color side_to_move) {
+    if (popcount(board.occupancy()) != 3 || popcount(board.pieces(Pawn)) != 1) {
+      return std::nullopt;
+    }
+    const Color strong = board.pieces(White, Pawn) ? White : Black;
+    const Color weak = strong == White ? Black : White;
+    return probe(strong, lsb(board.pieces(strong, King)), lsb(board.pieces(strong, Pawn)),
+                 lsb(board.pieces(weak, King)), side_to_move);
+  }
+}
+
+#endif
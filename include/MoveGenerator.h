@@ -2,6 +2,7 @@
 #define MOVEGENERATOR_H
 #include <GameTypes.h>
 #include <array>
+#include <optional>
 #include <vector>
 
 class MoveGenerator {
@@ -12,6 +13,99 @@ public:
 
   std::vector<Square> generate_pseudo_legal_moves(Square p);
 
+  struct CheckInfo {
+    int king_sqr;
+    Bitboard checkers;
+    Bitboard pinned;
+  };
+
+  /**
+   * Move subsets for generate(). Captures and Quiets split NonEvasions and are only
+   * meaningful when not in check, Evasions is for positions in check.
+   */
+  enum class GenType {
+    // Captures, en passant and every promotion, capturing or not
+    Captures,
+    // Moves to empty squares that are not promotions, including castling
+    Quiets,
+    // King moves, plus captures of and blocks against a single checker
+    Evasions,
+    // Every pseudo-legal move when not in check
+    NonEvasions
+  };
+
+  /*
+   * The bitboard generators below are templates over the board type so they serve
+   * both GameBoard and PositionSnapshot. A board type needs pieces(Color, PieceType),
+   * pieces(Color), pieces(PieceType), occupancy() and attackers_to(int, Bitboard).
+   */
+
+  /**
+   * Appends pseudo-legal pawn moves for color us whose destination is in target,
+   * expanding promotions into one move per piece type.
+   * @param en_passant Target square of a possible en passant capture, it is generated
+   * when either that square or the pawn it captures is in target
+   */
+  template<typename B>
+  static void generate_pawn_moves(const B& board, MoveList& list, Color us, Bitboard target,
+                                  std::optional<Square> en_passant);
+
+  /**
+   * Appends pseudo-legal moves of every knight, bishop, rook, queen or king (selected by t)
+   * of color us whose destination is in target. Castling is not included.
+   */
+  template<typename B>
+  static void generate_piece_moves(const B& board, MoveList& list, Color us, PieceType t, Bitboard target);
+
+  /**
+   * Appends castling moves allowed by castling_rights whose path is empty and not attacked,
+   * as long as the king and that rook still stand on their home squares. Only call this
+   * when us is not in check.
+   * @param castling_rights Bitmask of CastlingRight values
+   */
+  template<typename B>
+  static void generate_castling_moves(const B& board, MoveList& list, Color us, uint8_t castling_rights,
+                                      const CheckInfo& info);
+
+  /**
+   * @return The king square of us, the enemy pieces giving check and our pinned pieces
+   */
+  template<typename B>
+  static CheckInfo get_check_info(const B& board, Color us);
+
+  /**
+   * Decides whether a pseudo-legal move leaves the king safe, using the checkers and
+   * pinned pieces in info instead of making the move
+   */
+  template<typename B>
+  static bool is_legal(const B& board, Color us, PackedMove m, const CheckInfo& info);
+
+  /**
+   * Appends the pseudo-legal moves of one GenType subset for us, to be filtered with is_legal
+   * @param castling_rights Bitmask of CastlingRight values
+   */
+  template<GenType T, typename B>
+  static void generate(const B& board, MoveList& list, Color us, uint8_t castling_rights,
+                       std::optional<Square> en_passant, const CheckInfo& info);
+
+  /**
+   * Decides whether m is a move generate_legal_moves could produce before its legality
+   * filter, including the check evasion target. Used to validate moves that come from
+   * elsewhere, such as a hash table or another node, before trusting them.
+   * @param castling_rights Bitmask of CastlingRight values
+   */
+  template<typename B>
+  static bool is_pseudo_legal(const B& board, Color us, PackedMove m, uint8_t castling_rights,
+                              std::optional<Square> en_passant, const CheckInfo& info);
+
+  /**
+   * Fills list with every legal move for us
+   * @param castling_rights Bitmask of CastlingRight values
+   */
+  template<typename B>
+  static void generate_legal_moves(const B& board, MoveList& list, Color us, uint8_t castling_rights,
+                                   std::optional<Square> en_passant);
+
   static constexpr std::array knight_dir = {
     MoveDir{1, 2},
     MoveDir{ 1, -2},
@@ -71,8 +165,7 @@ private:
   std::vector<Square> generate_queen_pseudo_legal_moves(Piece p, Square s) const;
   std::vector<Square> generate_king_pseudo_legal_moves(Piece p, Square s) const;
 
-  template<size_t N>
-  std::vector<Square> generate_sliding_moves(const std::array<MoveDir, N>& dirs, Piece p, Square s) const;
+  static std::vector<Square> to_squares(Bitboard b);
 
   static Piece intToPiece(u_int8_t pos);
 
@@ -0,0 +1,78 @@
+#ifndef MOVEPICKER_H
+#define MOVEPICKER_H
+
+#include <ChessGame.h>
+#include <MoveGenerator.h>
+#include <array>
+#include <optional>
+
+/**
+ * Quiet move scores indexed by from and to square, raised when a quiet move causes a cutoff
+ */
+using HistoryTable = std::array<std::array<int, 64>, 64>;
+
+/**
+ * Hands out the legal moves of a position one at a time, best candidates first, and
+ * generates each group only once the previous one is used up: the hash move, captures
+ * and promotions by most valuable victim that do not lose material, the killer moves,
+ * the remaining quiet moves by history score, then the losing captures. A node that
+ * cuts off on an early move never generates or checks the quiet moves at all. In check
+ * the hash move is followed by the evasions alone, captures first.
+ */
+class MovePicker {
+public:
+  /**
+   * @param hash_move Move to try first, ignored unless legal here
+   * @param killers Quiet moves that caused cutoffs at this ply elsewhere, ignored unless legal here
+   * @param history Optional ordering for quiet moves
+   */
+  MovePicker(const ChessGame& game, PackedMove hash_move, const std::array<PackedMove, 2>& killers,
+             const HistoryTable* history);
+
+  /**
+   * Picker for quiescence search: the hash move when it is a capture or promotion, then
+   * the captures and promotions that do not lose material by static exchange. When the
+   * side to move is in check every evasion is returned.
+   */
+  MovePicker(const ChessGame& game, PackedMove hash_move);
+
+  /**
+   * @return The next legal move, or a null move once every move has been returned
+   */
+  PackedMove next();
+
+  bool in_check() const { return info.checkers; }
+
+private:
+  enum class Stage {
+    HashMove, GenerateCaptures, Captures, Killers, GenerateQuiets, Quiets, BadCaptures,
+    GenerateEvasions, Evasions, Done
+  };
+
+  template<MoveGenerator::GenType T>
+  void generate();
+  int capture_score(PackedMove m) const;
+  PackedMove pick_best();
+  bool is_tried(PackedMove m) const;
+  bool is_legal(PackedMove m) const;
+
+  const GameBoard& board;
+  Color us;
+  uint8_t castling_rights;
+  std::optional<Square> en_passant;
+  MoveGenerator::CheckInfo info;
+  PackedMove hash_move;
+  std::array<PackedMove, 2> killers{};
+  const HistoryTable* history{nullptr};
+  bool captures_only;
+
+  Stage stage{Stage::HashMove};
+  MoveList moves;
+  std::array<int, 256> scores;
+  // Captures that lose material by static exchange, tried after the quiet moves
+  MoveList bad_captures;
+  size_t current{};
+  size_t killer_index{};
+};
+
+#endif
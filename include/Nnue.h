@@ -0,0 +1,118 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <GameTypes.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+/*
+ * Efficiently updatable neural network evaluation with HalfKP inputs: every non-king
+ * piece paired with the square of one side's king, seen from that side. The first layer
+ * is a pair of accumulators, one per perspective, holding the sum of the weight columns
+ * of the active features. A move touches a handful of features, so the accumulators are
+ * updated by adding and subtracting those columns instead of being recomputed, except
+ * for the perspective whose king moved. The output layer reads both accumulators through
+ * a clipped ReLU, side to move first.
+ */
+namespace Nnue {
+  constexpr uint32_t file_version = 1;
+  constexpr size_t king_squares = 64;
+  constexpr size_t piece_kinds = 10;
+  constexpr size_t feature_count = king_squares * piece_kinds * 64;
+  constexpr size_t hidden_size = 256;
+
+  // Quantisation: activations clip to [0, activation_max], the output sum is divided by
+  // activation_max * weight_scale and multiplied by output_scale to give centipawns
+  constexpr int activation_max = 127;
+  constexpr int weight_scale = 64;
+  constexpr int output_scale = 400;
+
+  enum class Simd { Scalar, Sse2, Avx2 };
+
+  /**
+   * @return The widest kernel set this CPU supports
+   */
+  Simd detect_simd();
+
+  /**
+   * First layer output for both perspectives, indexed by GameBoard::color_index
+   */
+  struct alignas(64) Accumulator {
+    std::array<std::array<int16_t, hidden_size>, 2> values;
+  };
+
+  /**
+   * @return Input index of piece p on sq, seen from perspective whose king stands on king_sq.
+   * Black's view is flipped vertically so both sides share the weights.
+   */
+  constexpr size_t feature_index(Color perspective, int king_sq, Piece p, int sq) {
+    const int flip = perspective == Black ? 56 : 0;
+    const size_t kind = static_cast<size_t>(p.type - 1) * 2 + (p.color != perspective);
+    return (static_cast<size_t>(king_sq ^ flip) * piece_kinds + kind) * 64 + static_cast<size_t>(sq ^ flip);
+  }
+
+  /**
+   * Read-only weights memory-mapped from a file laid out little-endian as:
+   *   char magic[4] = "NNUE", uint32 version, uint32 feature_count, uint32 hidden_size,
+   *   int16 feature_bias[hidden_size], int16 feature_weights[feature_count][hidden_size],
+   *   int16 output_weights[2 * hidden_size], int32 output_bias
+   * The pages are shared between every search thread and every process using the file.
+   */
+  class Network {
+  public:
+    /**
+     * @throws std::runtime_error if the file cannot be mapped or its header or size
+     * does not match this build's layout
+     */
+    explicit Network(const std::string& path);
+    ~Network();
+    Network(const Network&) = delete;
+    Network& operator=(const Network&) = delete;
+
+    /**
+     * @return Expected size in bytes of a weights file
+     */
+    static constexpr size_t file_size() {
+      return 16 + sizeof(int16_t) * (hidden_size + feature_count * hidden_size + 2 * hidden_size) + sizeof(int32_t);
+    }
+
+    /**
+     * Recomputes perspective's half of acc from every piece on board
+     */
+    void refresh(Accumulator& acc, Color perspective, const GameBoard& board) const;
+
+    /**
+     * Adds the weight columns of added and subtracts those of removed in perspective's half of acc
+     */
+    void update(Accumulator& acc, Color perspective, std::span<const size_t> added,
+                std::span<const size_t> removed) const;
+
+    /**
+     * @return Centipawns from side's point of view
+     */
+    int evaluate(const Accumulator& acc, Color side) const;
+
+    /**
+     * Selects the kernels used by refresh, update and evaluate. Only kernels the CPU
+     * supports may be chosen, detect_simd() is used by default.
+     */
+    void set_simd(Simd s) { simd = s; }
+    Simd get_simd() const { return simd; }
+
+  private:
+    const int16_t* column(size_t feature) const { return feature_weights + feature * hidden_size; }
+
+    void* mapping{};
+    size_t mapping_size{};
+    const int16_t* feature_bias{};
+    const int16_t* feature_weights{};
+    const int16_t* output_weights{};
+    int32_t output_bias{};
+    Simd simd{Simd::Scalar};
+  };
+}
+
+#endif
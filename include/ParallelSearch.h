@@ -0,0 +1,68 @@
+#ifndef PARALLELSEARCH_H
+#define PARALLELSEARCH_H
+
+#include <Search.h>
+#include <ThreadPool.h>
+#include <TranspositionTable.h>
+#include <atomic>
+#include <memory>
+
+/**
+ * Lazy SMP: every thread runs its own Search on a private copy of the root position
+ * and the threads share nothing but the transposition table. Helpers skip some depths
+ * so they run ahead of the main search and fill the table with results it reuses.
+ * The reported move, score and PV are the main search's, node counts cover all threads.
+ */
+class ParallelSearch {
+public:
+  /**
+   * @param threads Total search threads including the caller's, at least 1
+   */
+  ParallelSearch(TranspositionTable& tt, size_t threads);
+
+  /**
+   * Searches game on the calling thread plus threads - 1 helpers. A node limit applies
+   * to the main search only, the helpers run until it finishes.
+   * @param on_iteration Called on the calling thread after each main search iteration
+   */
+  SearchResult run(const ChessGame& game, const SearchLimits& limits,
+                   const std::function<void(const SearchResult&)>& on_iteration = {});
+
+  /**
+   * Stops the running search, or the next one when none is running, and may be called
+   * from any thread. Searches given a SearchLimits::stop flag are stopped through that
+   * flag instead.
+   */
+  void stop();
+
+  /**
+   * Changes the thread count, must not be called during run()
+   */
+  void set_threads(size_t threads);
+  size_t threads() const { return pool ? pool->size() + 1 : 1; }
+
+  /**
+   * Tables every thread probes from the next run on, see Search::set_tablebases
+   */
+  void set_tablebases(const Tablebase::Tablebases* tables) { tablebases = tables; }
+
+  /**
+   * @return Transposition table counters of the last run, summed over every thread
+   */
+  const TTStats& tt_stats() const { return last_stats; }
+
+  /**
+   * @return Pawn table counters of the last run, summed over every thread
+   */
+  const PawnTableStats& pawn_stats() const { return last_pawn_stats; }
+
+private:
+  TranspositionTable& tt;
+  const Tablebase::Tablebases* tablebases{nullptr};
+  std::unique_ptr<ThreadPool> pool;
+  std::atomic<bool> stop_requested{false};
+  TTStats last_stats;
+  PawnTableStats last_pawn_stats;
+};
+
+#endif
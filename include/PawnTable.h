@@ -0,0 +1,63 @@
+#ifndef PAWNTABLE_H
+#define PAWNTABLE_H
+
+#include <Bitboard.h>
+#include <Evaluation.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Pawn structure terms of one pawn placement, white relative like the rest of the
+ * evaluation, indexed by GameBoard::color_index where a value is per side
+ */
+struct PawnEntry {
+  uint64_t key{};
+  Eval::Score score;
+  std::array<Bitboard, 2> passed{};
+  // Squares the side's pawns attack now or could attack after advancing
+  std::array<Bitboard, 2> attack_span{};
+};
+
+struct PawnTableStats {
+  uint64_t probes{};
+  uint64_t hits{};
+
+  double hit_rate() const { return probes ? static_cast<double>(hits) / static_cast<double>(probes) : 0.0; }
+  PawnTableStats& operator+=(const PawnTableStats& other);
+};
+
+/**
+ * @return Doubled, isolated, backward and passed pawn terms computed from scratch
+ */
+PawnEntry evaluate_pawns(Bitboard white_pawns, Bitboard black_pawns);
+
+/**
+ * Small direct-mapped cache of pawn structure evaluations keyed by the pawn-only
+ * Zobrist key. Pawn placements repeat across most of a search tree, so nearly every
+ * probe is a hit. Not thread safe, each search thread owns one.
+ */
+class PawnTable {
+public:
+  /**
+   * @param entries Rounded down to a power of two, at least 1
+   */
+  explicit PawnTable(size_t entries = 8192);
+
+  /**
+   * @param key GameBoard::pawn_key() of the position the pawns come from
+   * @return The cached entry for key, evaluated and stored first on a miss
+   */
+  const PawnEntry& probe(uint64_t key, Bitboard white_pawns, Bitboard black_pawns);
+
+  void clear();
+  size_t size() const { return table.size(); }
+  const PawnTableStats& stats() const { return counters; }
+
+private:
+  std::vector<PawnEntry> table;
+  PawnTableStats counters;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <ChessGame.h>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Fixed size table of subtree node counts keyed by position key and remaining depth.
+ * Each key maps to a single slot, and a stored count is only replaced by one from an
+ * equal or deeper search since deeper subtrees are the expensive ones to recount.
+ */
+class PerftCache {
+public:
+  /**
+   * @param size_mb Memory to use, rounded down to a power of two number of entries
+   */
+  explicit PerftCache(size_t size_mb);
+
+  bool probe(uint64_t key, int depth, uint64_t& nodes) const;
+  void store(uint64_t key, int depth, uint64_t nodes);
+  void clear();
+  size_t size() const { return entries.size(); }
+
+private:
+  struct Entry {
+    uint64_t key;
+    // Node count in the low 56 bits, depth in the top 8
+    uint64_t data;
+  };
+
+  std::vector<Entry> entries;
+  size_t mask{};
+};
+
+/**
+ * Counts the leaf nodes of the legal move tree below the current position.
+ * @param cache Optional table of subtree counts, shared across calls if desired
+ */
+uint64_t perft(ChessGame& game, int depth, PerftCache* cache = nullptr);
+
+struct RootMoveCount {
+  PackedMove move;
+  uint64_t nodes;
+};
+
+/**
+ * Perft split by root move, in the order the moves are generated
+ */
+std::vector<RootMoveCount> perft_divide(ChessGame& game, int depth, PerftCache* cache = nullptr);
+
+/**
+ * Perft split by root move, counted on a work-stealing thread pool. The tree is cut
+ * split_ply plies below the root and each subtree is a task; every worker replays
+ * its tasks on a private copy of the game. Results are summed per root move and
+ * returned in generation order, so the output is the same for any thread count.
+ * @param split_ply Depth of the cut, clamped to [1, min(depth, 8)]
+ * @param cache_mb When non-zero each worker gets its own PerftCache of this size
+ */
+std::vector<RootMoveCount> parallel_perft_divide(const ChessGame& game, int depth, size_t threads,
+                                                 int split_ply = 2, size_t cache_mb = 0);
+
+uint64_t parallel_perft(const ChessGame& game, int depth, size_t threads, int split_ply = 2, size_t cache_mb = 0);
+
+#endif
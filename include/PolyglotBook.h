@@ -0,0 +1,74 @@
+#ifndef POLYGLOTBOOK_H
+#define POLYGLOTBOOK_H
+
+#include <ChessGame.h>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+ * Polyglot opening books: files of 16 byte big-endian entries (key, move, weight,
+ * learn) sorted by key. The key is a Zobrist hash over Polyglot's own table of 781
+ * published random numbers, different from the engine's keys, so any standard book
+ * works as is.
+ */
+namespace Polyglot {
+  constexpr size_t random_count = 781;
+  constexpr uint64_t start_position_key = 0x463B96181691FC9CULL;
+
+  /**
+   * @return Polyglot key of the game's current position
+   */
+  uint64_t key(const ChessGame& game);
+
+  struct BookMove {
+    Move move;
+    uint16_t weight;
+  };
+
+  enum class Selection {
+    // The move with the highest weight
+    Best,
+    // A random move with probability proportional to its weight
+    Weighted
+  };
+
+  /**
+   * Read-only view of a book file mapped into memory. Lookups binary search the
+   * mapping directly, so opening a book costs nothing however large it is, and
+   * processes using the same book share one page-cached copy.
+   */
+  class Book {
+  public:
+    /**
+     * @throws std::runtime_error if the file cannot be mapped or is not a whole number of entries
+     */
+    explicit Book(const std::string& path);
+    ~Book();
+    Book(const Book&) = delete;
+    Book& operator=(const Book&) = delete;
+
+    size_t size() const { return entries; }
+
+    /**
+     * @return The book moves for the game's position that are legal in it, in file order.
+     * Castling stored as king takes rook is returned as the king's two square move.
+     */
+    std::vector<BookMove> moves(const ChessGame& game) const;
+
+    /**
+     * @return A book move for the game's position, if the book has one
+     */
+    std::optional<Move> pick(const ChessGame& game, Selection selection, std::mt19937_64& rng) const;
+
+  private:
+    void* mapping{};
+    size_t mapping_size{};
+    size_t entries{};
+  };
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef POSITIONSNAPSHOT_H
+#define POSITIONSNAPSHOT_H
+
+#include <GameTypes.h>
+#include <Kpk.h>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Complete position as a plain value: piece bitboards and mailbox, side to move,
+ * castling rights, en passant square, clocks and Zobrist key. It owns no heap memory
+ * and is trivially copyable, so threads can copy-make through a search with
+ * make_move instead of sharing a ChessGame. Keys match ChessGame::key() for the
+ * same position.
+ */
+class PositionSnapshot {
+public:
+  PositionSnapshot() = default;
+
+  PositionSnapshot(const GameBoard& board, Color side_to_move, uint8_t castling_rights,
+                   std::optional<Square> en_passant, uint16_t half_move_clock, uint16_t full_moves, uint64_t key);
+
+  /**
+   * Position holding only the given pieces, with no castling rights or en passant square.
+   * The key is computed from the pieces and side to move.
+   */
+  PositionSnapshot(std::span<const std::pair<Piece, int>> pieces, Color side_to_move);
+
+  Piece at(int sq) const { return GameBoard::intToPiece(board[sq]); }
+  Bitboard pieces(Color c, PieceType t) const { return piece_bb[GameBoard::piece_index({t, c})]; }
+  Bitboard pieces(Color c) const { return color_bb[GameBoard::color_index(c)]; }
+  Bitboard pieces(PieceType t) const { return pieces(White, t) | pieces(Black, t); }
+  Bitboard occupancy() const { return color_bb[0] | color_bb[1]; }
+  Bitboard attackers_to(int sq, Bitboard occupied) const;
+
+  Color side_to_move() const { return side; }
+  uint8_t castling_rights() const { return castling; }
+  std::optional<Square> en_passant() const;
+  uint16_t half_move_clock() const { return half_moves; }
+  uint16_t full_moves() const { return full_move_count; }
+  uint64_t key() const { return hash; }
+  uint64_t pawn_key() const { return pawn_hash; }
+  Eval::Score psq_score() const { return psq; }
+  int game_phase() const { return phase; }
+  bool in_check() const;
+
+  /**
+   * @return Tapered static evaluation from side's point of view, same as GameBoard::evaluate
+   */
+  int evaluate(Color c) const {
+    const int score = Eval::taper(psq, phase);
+    return c == Black ? -score : score;
+  }
+
+  /**
+   * @return Same as ChessGame::probe_kpk
+   */
+  std::optional<bool> probe_kpk() const { return Kpk::probe(*this, side); }
+
+  /**
+   * Static exchange evaluation of a legal move, see See.h
+   */
+  int see(PackedMove m) const;
+  bool see_ge(PackedMove m, int threshold = 0) const;
+
+  /**
+   * @param m A legal move in this position
+   * @return The position after m, this one is left unchanged
+   */
+  [[nodiscard]] PositionSnapshot make_move(PackedMove m) const;
+  void generate_legal_moves(MoveList& list) const;
+
+  bool operator==(const PositionSnapshot&) const = default;
+
+private:
+  void put_piece(Piece p, int sq);
+  void remove_piece(int sq);
+
+  std::array<Bitboard, 12> piece_bb{};
+  std::array<Bitboard, 2> color_bb{};
+  Board board{};
+  uint64_t hash{};
+  uint64_t pawn_hash{};
+  Eval::Score psq{};
+  int phase{};
+  Color side{White};
+  uint8_t castling{};
+  int8_t en_passant_sqr{-1};
+  uint16_t half_moves{};
+  uint16_t full_move_count{1};
+};
+
+static_assert(std::is_trivially_copyable_v<PositionSnapshot>);
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <ChessGame.h>
+#include <MovePicker.h>
+#include <PawnTable.h>
+#include <Tablebase.h>
+#include <TranspositionTable.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * Bounds on a search. A zero node count or move time means no limit on that axis.
+ */
+struct SearchLimits {
+  int depth{64};
+  uint64_t nodes{0};
+  std::chrono::milliseconds move_time{0};
+  // Optional flag shared by several searches, any of them stops once it is set
+  const std::atomic<bool>* stop{nullptr};
+};
+
+/**
+ * Outcome of the last fully searched iteration
+ */
+struct SearchResult {
+  PackedMove best_move;
+  // Centipawns from the side to move's point of view, see Search::mate_score for mates
+  int score{};
+  int depth{};
+  uint64_t nodes{};
+  std::chrono::milliseconds elapsed{};
+  std::vector<PackedMove> pv;
+};
+
+/**
+ * Iterative deepening negamax with alpha-beta pruning and a captures only quiescence
+ * search at the horizon. The search plays moves on its own copy of the game, so the
+ * caller's game is left untouched and stop() may be called from another thread.
+ * An optional transposition table supplies cutoffs and the first move to try; it
+ * may be shared with other searches running at the same time.
+ */
+class Search {
+public:
+  static constexpr int max_ply = 128;
+  static constexpr int infinite_score = 32001;
+  // Mate in n plies scores mate_score - n for the side delivering it
+  static constexpr int mate_score = 32000;
+  static constexpr int mate_bound = mate_score - max_ply;
+  // Added to the evaluation of endgames a bitbase reports as won, far below any mate
+  static constexpr int known_win = 10000;
+
+  /**
+   * @param thread_index 0 for a standalone or main search. Higher indexes mark Lazy SMP
+   * helpers, which skip some iterations so that helpers spread over different depths,
+   * and leave the table's generation to the main search.
+   */
+  explicit Search(const ChessGame& game, TranspositionTable* tt = nullptr, size_t thread_index = 0);
+
+  /**
+   * Searches until limits are reached or stop() is called.
+   * @param on_iteration Called after each completed depth with the result so far
+   * @return Result of the deepest completed iteration. When not even depth 1 completed
+   * the best move is the first legal move and the score is 0.
+   */
+  SearchResult run(const SearchLimits& limits,
+                   const std::function<void(const SearchResult&)>& on_iteration = {});
+
+  /**
+   * Stops the current run, or the next one when none is running. Safe to call from any
+   * thread, the request is used up when run() returns.
+   */
+  void stop();
+
+  /**
+   * Probes tables below the root from the next run on, null to stop probing. Positions
+   * a table covers score as mates or draws without being searched.
+   */
+  void set_tablebases(const Tablebase::Tablebases* tables) { tablebases = tables; }
+
+  /**
+   * @return Nodes searched so far in the current or last run, safe to read from any
+   * thread and refreshed every few thousand nodes while searching
+   */
+  uint64_t nodes_searched() const { return published_nodes.load(std::memory_order_relaxed); }
+
+  static bool is_mate_score(int score) {
+    return score >= mate_bound || score <= -mate_bound;
+  }
+
+  /**
+   * @return Transposition table counters of this search, accumulated over every run
+   */
+  const TTStats& tt_stats() const { return tt_counters; }
+  const PawnTableStats& pawn_stats() const { return pawns.stats(); }
+
+private:
+  int negamax(int depth, int ply, int alpha, int beta);
+  int quiescence(int ply, int alpha, int beta);
+  int evaluate();
+  void update_quiet_stats(int ply, int depth, PackedMove move);
+  bool should_stop();
+  void update_pv(int ply, PackedMove move);
+
+  ChessGame game;
+  TranspositionTable* tt;
+  size_t thread_index;
+  const Tablebase::Tablebases* tablebases{nullptr};
+  TTStats tt_counters;
+  PawnTable pawns;
+  SearchLimits limits;
+  std::chrono::steady_clock::time_point start;
+  std::atomic<bool> stop_requested{false};
+  bool aborted{false};
+  uint64_t nodes{};
+  std::atomic<uint64_t> published_nodes{0};
+
+  // Triangular PV table, row ply holds the best line found from that ply
+  std::array<std::array<PackedMove, max_ply>, max_ply> pv{};
+  std::array<int, max_ply> pv_length{};
+  // Principal variation of the previous iteration, tried first at each ply
+  std::array<PackedMove, max_ply> prev_pv{};
+  // Last two quiet moves per ply that caused a cutoff
+  std::array<std::array<PackedMove, 2>, max_ply> killers{};
+  HistoryTable history{};
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef SEE_H
+#define SEE_H
+
+#include <GameTypes.h>
+
+/*
+ * Static exchange evaluation: the material balance of the capture sequence on a move's
+ * destination square when both sides always recapture with their least valuable piece
+ * and may stop once continuing would lose material. Sliders uncovered behind a capturer
+ * join in as x-rays. Nothing is played on the board and pins are not considered.
+ * Templates over the board type like MoveGenerator, for GameBoard and PositionSnapshot.
+ */
+
+/**
+ * @param m A pseudo-legal move on board
+ * @return Centipawns gained by the side making m, 0 for quiet moves that cannot be captured
+ */
+template<typename B>
+int see(const B& board, PackedMove m);
+
+/**
+ * @return Whether see(board, m) >= threshold, usually faster since it stops as soon as
+ * the answer is known
+ */
+template<typename B>
+bool see_ge(const B& board, PackedMove m, int threshold);
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <PositionSnapshot.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+/*
+ * Distance to mate tablebases for endings of up to four pieces, generated locally by
+ * retrograde analysis. A table covers one material signature such as "KQvKR", white
+ * being the stronger side; positions with the colours the other way round are
+ * mirrored onto it. Tables are indexed with the board's symmetry: without pawns the
+ * white king is kept in the a1-d1-d4 triangle, with pawns on files a to d.
+ *
+ * File format, little-endian: "CETB", u32 version, char[8] signature, u64 entries,
+ * then one byte per entry for white to move followed by the same for black. A byte
+ * is 0 for a draw, 255 for a position that is illegal or stands for a mirrored one,
+ * and otherwise 1 + plies to mate, odd plies meaning the side to move mates and even
+ * plies that it is mated. En passant rights are not part of a position, so a double
+ * push that allows an en passant capture is scored by the better of the table's entry
+ * and that capture for the opponent.
+ */
+namespace Tablebase {
+  // Version 1 tables ignored en passant replies to double pushes
+  constexpr uint32_t file_version = 2;
+  constexpr size_t max_pieces = 4;
+  // Longest mate the one byte entries can hold
+  constexpr int max_plies = 252;
+
+  enum class Wdl : int8_t {
+    Loss = -1,
+    Draw = 0,
+    Win = 1
+  };
+
+  struct ProbeResult {
+    // From the side to move's point of view
+    Wdl wdl;
+    // Plies until mate with best play, 0 for draws
+    int plies;
+  };
+
+  /**
+   * @return Every three and four piece signature, each listed after the tables its
+   * captures and promotions lead to
+   */
+  std::vector<std::string> all_signatures();
+
+  /**
+   * Set of tables mapped read-only from their files. Probing looks the table up by
+   * material in a flat array and reads one byte, so it costs about as much as a
+   * transposition table probe. Safe to probe from several threads.
+   */
+  class Tablebases {
+  public:
+    Tablebases();
+    ~Tablebases();
+    Tablebases(const Tablebases&) = delete;
+    Tablebases& operator=(const Tablebases&) = delete;
+
+    /**
+     * Maps one table file, replacing a loaded table of the same signature
+     * @throws std::runtime_error if the file cannot be mapped or is not a table
+     */
+    void add(const std::string& path);
+
+    /**
+     * Maps every .dtm file in directory
+     * @return Number of tables mapped
+     * @throws std::runtime_error as add does
+     */
+    size_t load_directory(const std::string& directory);
+
+    bool contains(const std::string& signature) const;
+    size_t size() const { return tables.size(); }
+
+    /**
+     * @return Result for the side to move, or nullopt when no loaded table covers the
+     * position or it has castling rights or an en passant square. Bare kings are a draw.
+     */
+    std::optional<ProbeResult> probe(const PositionSnapshot& position) const;
+
+  private:
+    struct Table;
+
+    std::vector<std::unique_ptr<Table>> tables;
+    // Indexed by material key, see Tablebase.cpp
+    std::vector<const Table*> by_material;
+  };
+
+  struct GenerationStats {
+    uint64_t positions{};
+    uint64_t wins{};
+    uint64_t draws{};
+    uint64_t losses{};
+    int longest_mate{};
+    std::chrono::duration<double> elapsed{};
+  };
+
+  /**
+   * Solves signature and writes it to directory/<signature>.dtm, then adds it to tables.
+   * An existing file is replaced by renaming over it, so processes that map it keep the old table.
+   * Moves that capture or promote are looked up in tables, so the tables for those
+   * signatures must be loaded first, see all_signatures.
+   * @param threads Worker threads, at least 1
+   * @throws std::runtime_error for an unknown signature, a missing table or a write error
+   */
+  GenerationStats generate(const std::string& signature, const std::string& directory, Tablebases& tables,
+                           size_t threads);
+}
+
+#endif
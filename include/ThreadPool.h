@@ -0,0 +1,65 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads, each with its own task deque. A worker takes new work
+ * from the back of its own deque and, once that is empty, steals from the front of
+ * the others, so uneven tasks still keep every core busy.
+ */
+class ThreadPool {
+public:
+  /**
+   * Tasks receive the index of the worker running them, which lets callers keep
+   * per-worker state such as a private ChessGame without locking.
+   */
+  using Task = std::function<void(size_t worker)>;
+
+  explicit ThreadPool(size_t threads);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * Queues a task, spreading tasks round robin over the worker deques
+   */
+  void submit(Task task);
+
+  /**
+   * Blocks until every submitted task has finished
+   */
+  void wait();
+
+  size_t size() const { return workers.size(); }
+
+private:
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void worker_loop(size_t index);
+  bool try_pop(size_t index, Task& task);
+  bool try_steal(size_t index, Task& task);
+
+  std::vector<std::unique_ptr<WorkQueue>> queues;
+  std::vector<std::thread> workers;
+  std::mutex state_mutex;
+  std::condition_variable work_available;
+  std::condition_variable all_done;
+  std::atomic<size_t> queued{0};
+  std::atomic<size_t> pending{0};
+  std::atomic<size_t> next_queue{0};
+  bool stopping{false};
+};
+
+#endif
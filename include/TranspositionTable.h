@@ -0,0 +1,120 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <GameTypes.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+enum class Bound : uint8_t {
+  None, Upper, Lower, Exact
+};
+
+/**
+ * Unpacked copy of a table entry
+ */
+struct TTEntry {
+  PackedMove move;
+  int score{};
+  int depth{};
+  Bound bound{Bound::None};
+};
+
+/**
+ * Counters for one user of the table. They are kept by the caller rather than the
+ * table so that threads sharing a table never write to a common counter.
+ */
+struct TTStats {
+  uint64_t probes{};
+  uint64_t hits{};
+  // Probes that found their bucket filled by other positions
+  uint64_t collisions{};
+  uint64_t stores{};
+  // Stores that evicted a different position written during the current search
+  uint64_t overwrites{};
+
+  TTStats& operator+=(const TTStats& other);
+};
+
+/**
+ * Shared hash table of search results, safe to use from many threads without locks.
+ * Each 64 byte bucket holds four entries of two words, the packed data and the key
+ * XORed with that data. A reader recomputes the key from both words, so an entry torn
+ * by a concurrent writer fails verification and reads as a miss instead of returning
+ * another position's data.
+ */
+class TranspositionTable {
+public:
+  static constexpr size_t bucket_size = 4;
+
+  /**
+   * @param size_mb Memory to use, rounded down to a power of two number of buckets
+   * @param huge_pages Ask the kernel to back the table with transparent huge pages
+   */
+  explicit TranspositionTable(size_t size_mb, bool huge_pages = true);
+
+  /**
+   * Reallocates and clears the table. Not safe while other threads use it.
+   */
+  void resize(size_t size_mb);
+
+  /**
+   * Empties the table. Not safe while other threads use it.
+   */
+  void clear();
+
+  /**
+   * Starts a new search generation, entries from older searches are replaced first
+   */
+  void new_search();
+
+  bool probe(uint64_t key, TTEntry& entry, TTStats* stats = nullptr) const;
+
+  /**
+   * Writes an entry for key. An existing entry for the same position keeps its move
+   * when none is given and is only replaced by an equal or deeper result, or an exact one.
+   */
+  void store(uint64_t key, PackedMove move, int score, int depth, Bound bound, TTStats* stats = nullptr);
+
+  /**
+   * Hints the CPU to load the bucket for key, call it as soon as the key is known
+   */
+  void prefetch(uint64_t key) const {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(&buckets[key & mask]);
+#endif
+  }
+
+  /**
+   * @return Permille of sampled entries written during the current search
+   */
+  int hashfull() const;
+
+  size_t size_mb() const { return bucket_count * sizeof(Bucket) >> 20; }
+  size_t entry_count() const { return bucket_count * bucket_size; }
+
+private:
+  struct Entry {
+    std::atomic<uint64_t> key_xor_data;
+    std::atomic<uint64_t> data;
+  };
+
+  struct alignas(64) Bucket {
+    Entry entries[bucket_size];
+  };
+  static_assert(sizeof(Bucket) == 64);
+
+  struct Free {
+    void operator()(Bucket* b) const;
+  };
+
+  std::unique_ptr<Bucket[], Free> buckets;
+  size_t bucket_count{};
+  size_t mask{};
+  bool huge_pages;
+  // Read by every thread using the table, bumped once per search
+  std::atomic<uint8_t> generation{};
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef UCI_H
+#define UCI_H
+
+#include <ChessGame.h>
+#include <Nnue.h>
+#include <ParallelSearch.h>
+#include <PolyglotBook.h>
+#include <Tablebase.h>
+#include <TranspositionTable.h>
+#include <atomic>
+#include <condition_variable>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+
+/**
+ * Universal Chess Interface front end. Commands are read from in and answered on out;
+ * go starts the search on a background thread so stop, isready and quit are answered
+ * while it runs. Supports position, go (depth, nodes, movetime, wtime/btime/winc/binc,
+ * movestogo, infinite), stop, isready, ucinewgame, setoption Hash, Threads, EvalFile,
+ * BookFile and TablebasePath, plus perft N (or go perft N) to count the legal move tree.
+ * Once BookFile is set, go answers positions in the book without searching.
+ */
+class UciEngine {
+public:
+  UciEngine(std::istream& in, std::ostream& out);
+  ~UciEngine();
+  UciEngine(const UciEngine&) = delete;
+  UciEngine& operator=(const UciEngine&) = delete;
+
+  /**
+   * Handles commands until quit or the end of input, then stops any search
+   */
+  void loop();
+
+  /**
+   * Handles a single command line
+   * @return false once the command was quit
+   */
+  bool execute(const std::string& line);
+
+  /**
+   * Blocks until the running search, if any, has printed its bestmove
+   */
+  void wait_for_search();
+
+private:
+  void uci();
+  void set_option(std::istringstream& args);
+  void position(std::istringstream& args);
+  void go(std::istringstream& args);
+  void perft(int depth);
+  void stop_search();
+  void send(const std::string& line);
+
+  std::istream& in;
+  std::ostream& out;
+  std::mutex out_mutex;
+
+  size_t threads{1};
+  TranspositionTable tt;
+  ParallelSearch search;
+  std::unique_ptr<Nnue::Network> network;
+  std::unique_ptr<Polyglot::Book> book;
+  std::mt19937_64 book_rng{std::random_device{}()};
+  std::unique_ptr<Tablebase::Tablebases> tablebases;
+  std::unique_ptr<ChessGame> game;
+
+  std::thread worker;
+  std::atomic<bool> stop_flag{false};
+  // Lets an infinite search hold back its bestmove until stop or quit arrives
+  std::mutex stop_mutex;
+  std::condition_variable stop_cv;
+};
+
+#endif
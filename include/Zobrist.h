@@ -0,0 +1,49 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Random keys for Zobrist hashing. They are produced at compile time by splitmix64
+ * from a fixed seed, so a position's key is the same in every build and process.
+ */
+namespace Zobrist {
+  struct Keys {
+    // Indexed by GameBoard piece index (0-5 white pawn..king, 6-11 black) then square
+    std::array<std::array<uint64_t, 64>, 12> piece_square;
+    // Indexed by the castling rights bitmask, bit 0 white king side through bit 3 black queen side
+    std::array<uint64_t, 16> castling;
+    std::array<uint64_t, 8> en_passant_file;
+    uint64_t black_to_move;
+  };
+
+  constexpr uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  constexpr Keys make_keys() {
+    Keys k{};
+    uint64_t state = 1070372;
+    for (auto& piece : k.piece_square) {
+      for (auto& key : piece) {
+        key = splitmix64(state);
+      }
+    }
+    for (auto& key : k.castling) {
+      key = splitmix64(state);
+    }
+    for (auto& key : k.en_passant_file) {
+      key = splitmix64(state);
+    }
+    k.black_to_move = splitmix64(state);
+    return k;
+  }
+
+  inline constexpr Keys keys = make_keys();
+}
+
+#endif
@@ -1,6 +1,8 @@
-
+#include <Uci.h>
 #include <iostream>
+
 int main() {
-  std::cout << "hello world\n";
+  UciEngine engine(std::cin, std::cout);
+  engine.loop();
   return 0;
 }
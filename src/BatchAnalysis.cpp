@@ -0,0 +1,221 @@
+#include <BatchAnalysis.h>
+#include <ChessGame.h>
+#include <Fen.h>
+#include <PawnTable.h>
+#include <Perft.h>
+#include <ThreadPool.h>
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+namespace {
+  std::vector<std::string_view> split_fields(std::string_view line) {
+    std::vector<std::string_view> fields;
+    size_t pos = 0;
+    while (true) {
+      pos = line.find_first_not_of(" \t", pos);
+      if (pos == std::string_view::npos) {
+        return fields;
+      }
+      const size_t end = std::min(line.find_first_of(" \t", pos), line.size());
+      fields.push_back(line.substr(pos, end - pos));
+      pos = end;
+    }
+  }
+
+  // Leaves value alone unless all of s is a number that fits
+  bool parse_clock(std::string_view s, uint16_t& value) {
+    uint16_t parsed{};
+    const auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), parsed);
+    if (s.empty() || ec != std::errc{} || ptr != s.data() + s.size()) {
+      return false;
+    }
+    value = parsed;
+    return true;
+  }
+
+  /**
+   * Reads the four position fields of line with Fen::parse, then the clocks from the
+   * two fields after them or from the hmvc and fmvn operations
+   */
+  std::optional<Fen::Position> parse_epd(std::string_view line, std::string& error) {
+    const auto fields = split_fields(line);
+    if (fields.size() < 4) {
+      error = Fen::message(Fen::Error::MissingField);
+      return std::nullopt;
+    }
+    const std::string_view position_fields(fields[0].data(), fields[3].data() + fields[3].size());
+    auto position = Fen::parse(position_fields);
+    if (!position) {
+      error = Fen::message(position.error());
+      return std::nullopt;
+    }
+    // Fen accepts partial boards, analysis needs a king on each side
+    const auto kings = [&](Color c) {
+      return std::ranges::count_if(position->squares, [c](Piece p) { return p.type == King && p.color == c; });
+    };
+    if (kings(White) != 1 || kings(Black) != 1) {
+      error = "each side needs exactly one king";
+      return std::nullopt;
+    }
+
+    uint16_t half_moves = 0;
+    uint16_t full_moves = 1;
+    if (fields.size() >= 6 && parse_clock(fields[4], half_moves) && parse_clock(fields[5], full_moves)) {
+      position->half_move_clock = half_moves;
+      position->full_moves = full_moves;
+      return *position;
+    }
+    half_moves = 0;
+    for (size_t i = 4; i + 1 < fields.size(); ++i) {
+      std::string_view value = fields[i + 1];
+      if (value.ends_with(';')) {
+        value.remove_suffix(1);
+      }
+      if (fields[i] == "hmvc") {
+        parse_clock(value, half_moves);
+      } else if (fields[i] == "fmvn") {
+        parse_clock(value, full_moves);
+      }
+    }
+    position->half_move_clock = half_moves;
+    position->full_moves = full_moves;
+    return *position;
+  }
+
+  struct Chunk {
+    size_t index{};
+    uint64_t errors{};
+    std::vector<std::string> lines;
+    std::vector<std::string> results;
+  };
+
+  std::string analyse(const std::string& line, const BatchOptions& options, PawnTable& pawns, bool& failed) {
+    std::string error;
+    const auto position = parse_epd(line, error);
+    if (!position) {
+      failed = true;
+      return "error: " + error;
+    }
+    try {
+      ChessGame game(*position);
+      switch (options.operation) {
+        case BatchOperation::LegalMoves: {
+          MoveList moves;
+          game.generate_legal_moves(moves);
+          return std::to_string(moves.size());
+        }
+        case BatchOperation::Perft:
+          return std::to_string(perft(game, options.depth));
+        case BatchOperation::Evaluate:
+          return std::to_string(game.evaluate(&pawns));
+      }
+    } catch (const std::exception& e) {
+      failed = true;
+      return std::string("error: ") + e.what();
+    }
+    return {};
+  }
+}
+
+std::string epd_to_fen(std::string_view line, std::string& error) {
+  const auto position = parse_epd(line, error);
+  return position ? Fen::to_string(*position) : std::string{};
+}
+
+BatchStats analyse_batch(std::istream& in, std::ostream& out, const BatchOptions& options) {
+  const auto start = std::chrono::steady_clock::now();
+  const size_t threads = std::max<size_t>(options.threads, 1);
+  const size_t chunk_lines = std::max<size_t>(options.chunk_lines, 1);
+
+  ThreadPool pool(threads);
+  std::vector<PawnTable> pawns(threads);
+  // Taken by the reader for every chunk and returned once the writer has printed it
+  std::counting_semaphore<> free_slots(static_cast<std::ptrdiff_t>(std::max<size_t>(options.max_chunks_in_flight, 1)));
+  std::mutex done_mutex;
+  std::condition_variable chunk_done;
+  std::map<size_t, Chunk> done;
+  size_t chunks_read = 0;
+  bool reading_finished = false;
+  BatchStats stats;
+
+  std::thread writer([&] {
+    for (size_t next = 0;; ++next) {
+      Chunk chunk;
+      {
+        std::unique_lock lock(done_mutex);
+        chunk_done.wait(lock, [&] { return done.contains(next) || (reading_finished && next == chunks_read); });
+        if (!done.contains(next)) {
+          return;
+        }
+        chunk = std::move(done.extract(next).mapped());
+      }
+      for (size_t i = 0; i < chunk.lines.size(); ++i) {
+        out << chunk.lines[i] << '\t' << chunk.results[i] << '\n';
+      }
+      stats.positions += chunk.lines.size();
+      stats.errors += chunk.errors;
+      free_slots.release();
+    }
+  });
+
+  Chunk chunk;
+  auto submit = [&] {
+    free_slots.acquire();
+    {
+      std::lock_guard lock(done_mutex);
+      chunk.index = chunks_read++;
+    }
+    pool.submit([&, task = std::make_shared<Chunk>(std::move(chunk))](size_t worker) {
+      task->results.reserve(task->lines.size());
+      for (const std::string& line : task->lines) {
+        bool failed = false;
+        task->results.push_back(analyse(line, options, pawns[worker], failed));
+        task->errors += failed;
+      }
+      {
+        std::lock_guard lock(done_mutex);
+        done.emplace(task->index, std::move(*task));
+      }
+      chunk_done.notify_all();
+    });
+    chunk = Chunk{};
+  };
+
+  for (std::string line; std::getline(in, line);) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    const size_t first = line.find_first_not_of(" \t");
+    if (first == std::string::npos || line[first] == '#') {
+      continue;
+    }
+    chunk.lines.push_back(std::move(line));
+    if (chunk.lines.size() == chunk_lines) {
+      submit();
+    }
+  }
+  if (!chunk.lines.empty()) {
+    submit();
+  }
+  {
+    std::lock_guard lock(done_mutex);
+    reading_finished = true;
+  }
+  chunk_done.notify_all();
+  writer.join();
+  pool.wait();
+  out.flush();
+
+  stats.elapsed = std::chrono::steady_clock::now() - start;
+  return stats;
+}
@@ -0,0 +1,120 @@
+#include <Bitboard.h>
+#include <cstddef>
+#include <vector>
+
+namespace {
+  // Filled once by build_tables(), read through Bitboards::tables()
+  Bitboards::Tables storage{};
+  // Sizes of the shared attack tables when every square uses the minimum index width
+  std::array<Bitboard, 0x19000> rook_table{};
+  std::array<Bitboard, 0x1480> bishop_table{};
+
+  constexpr std::array<std::array<int, 2>, 4> bishop_rays = {{{1, 1}, {1, -1}, {-1, 1}, {-1, -1}}};
+  constexpr std::array<std::array<int, 2>, 4> rook_rays = {{{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
+
+  /**
+   * xorshift64star, seeded per rank so the magic search is deterministic and fast
+   */
+  class Prng {
+    uint64_t s;
+  public:
+    explicit Prng(uint64_t seed) : s(seed) {}
+
+    uint64_t rand() {
+      s ^= s >> 12;
+      s ^= s << 25;
+      s ^= s >> 27;
+      return s * 2685821657736338717ULL;
+    }
+
+    uint64_t sparse_rand() {
+      return rand() & rand() & rand();
+    }
+  };
+
+  Bitboard sliding_attack(const std::array<std::array<int, 2>, 4>& rays, int sq, Bitboard occupied) {
+    Bitboard attacks = 0;
+    for (const auto& [rank_dir, file_dir] : rays) {
+      int rank = (sq >> 3) + rank_dir;
+      int file = (sq & 7) + file_dir;
+      while (rank >= 0 && rank < 8 && file >= 0 && file < 8) {
+        const Bitboard b = square_bb(rank * 8 + file);
+        attacks |= b;
+        if (occupied & b) {
+          break;
+        }
+        rank += rank_dir;
+        file += file_dir;
+      }
+    }
+    return attacks;
+  }
+
+  void init_magics(const std::array<std::array<int, 2>, 4>& rays, std::array<Magic, 64>& magics, Bitboard* table) {
+    static constexpr std::array<uint64_t, 8> seeds = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+    std::vector<Bitboard> occupancy(4096);
+    std::vector<Bitboard> reference(4096);
+    std::vector<int> epoch(4096);
+    int attempt = 0;
+    size_t size = 0;
+
+    for (int sq = 0; sq < 64; ++sq) {
+      // Board edges are never relevant blockers unless the slider stands on that edge
+      const Bitboard edges = ((Rank1BB | Rank8BB) & ~(Rank1BB << (8 * (sq >> 3)))) |
+                             ((FileABB | FileHBB) & ~(FileABB << (sq & 7)));
+      Magic& m = magics[sq];
+      m.mask = sliding_attack(rays, sq, 0) & ~edges;
+      m.shift = 64 - popcount(m.mask);
+      m.attacks = sq == 0 ? table : magics[sq - 1].attacks + size;
+
+      // Carry-Rippler enumeration of every subset of the mask
+      Bitboard b = 0;
+      size = 0;
+      do {
+        occupancy[size] = b;
+        reference[size] = sliding_attack(rays, sq, b);
+        size++;
+        b = (b - m.mask) & m.mask;
+      } while (b);
+
+      Prng rng(seeds[sq >> 3]);
+      for (size_t i = 0; i < size;) {
+        for (m.magic = 0; popcount((m.magic * m.mask) >> 56) < 6;) {
+          m.magic = rng.sparse_rand();
+        }
+        // epoch marks which slots were written by the current candidate so the
+        // table never has to be cleared between attempts
+        for (++attempt, i = 0; i < size; ++i) {
+          const unsigned idx = m.index(occupancy[i]);
+          if (epoch[idx] < attempt) {
+            epoch[idx] = attempt;
+            m.attacks[idx] = reference[i];
+          } else if (m.attacks[idx] != reference[i]) {
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+const Bitboards::Tables& Bitboards::build_tables() {
+  init_magics(rook_rays, storage.rook_magics, rook_table.data());
+  init_magics(bishop_rays, storage.bishop_magics, bishop_table.data());
+
+  // tables() is still running its initializer here, so the attacks come from the magics directly
+  const auto attacks = [](const Magic& m, Bitboard occupied) { return m.attacks[m.index(occupied)]; };
+  for (int a = 0; a < 64; ++a) {
+    for (int b = 0; b < 64; ++b) {
+      for (const auto* magics : {&storage.bishop_magics, &storage.rook_magics}) {
+        const Magic& ma = (*magics)[a];
+        const Magic& mb = (*magics)[b];
+        if (a != b && (attacks(ma, 0) & square_bb(b))) {
+          storage.line[a][b] = (attacks(ma, 0) & attacks(mb, 0)) | square_bb(a) | square_bb(b);
+          storage.between[a][b] = attacks(ma, square_bb(b)) & attacks(mb, square_bb(a));
+        }
+      }
+    }
+  }
+  return storage;
+}
@@ -2,76 +2,119 @@
 #include <util.h>
 #include <cassert>
 #include <GameTypes.h>
+#include <See.h>
 #include <algorithm>
-#include <functional>
 #include <iostream>
-#include <span>
-#include <sstream>
+#include <optional>
 #include <format>
-#include<source_location>
+#include <stdexcept>
 
 ChessGame::ChessGame()
-: move_gen(board)
-, piece_list(board.get_piece_list()){
+: move_gen(board) {
   move_history.reserve(1024);
+  state.key = compute_key();
 }
 
 
-ChessGame::ChessGame(const std::string& fen)
-: move_gen(board)
-, piece_list(board.get_piece_list()) {
+ChessGame::ChessGame(const ChessGame& other)
+: board(other.board)
+, move_gen(board)
+, state(other.state)
+, move_history(other.move_history)
+, prev_state(other.prev_state)
+, network(other.network)
+, accumulators(other.accumulators) {}
+
+
+ChessGame::ChessGame(ChessGame&& other) noexcept
+: board(std::move(other.board))
+, move_gen(board)
+, state(other.state)
+, move_history(std::move(other.move_history))
+, prev_state(std::move(other.prev_state))
+, network(other.network)
+, accumulators(std::move(other.accumulators)) {}
+
+
+ChessGame::ChessGame(const PositionSnapshot& position)
+: move_gen(board) {
+  board.clear();
+  Bitboard occupied = position.occupancy();
+  while (occupied) {
+    const int sq = pop_lsb(occupied);
+    board.set_piece(position.at(sq), to_square(sq));
+  }
+  const uint8_t rights = position.castling_rights();
+  state.current_turn = position.side_to_move();
+  state.k_rook_white_moved = !(rights & WhiteKingSide);
+  state.q_rook_white_moved = !(rights & WhiteQueenSide);
+  state.k_rook_black_moved = !(rights & BlackKingSide);
+  state.q_rook_black_moved = !(rights & BlackQueenSide);
+  if (const auto en_passant = position.en_passant()) {
+    state.en_passant_target_square = *en_passant;
+    state.passant_sqr_exists = true;
+  }
+  state.half_move_clock = position.half_move_clock();
+  state.full_moves = position.full_moves();
+  state.key = compute_key();
+}
 
-  std::array<std::string, 6> fields{};
-  const std::source_location& location = std::source_location::current();
-  std::istringstream fen_fields{fen.data()};
-  try {
-    for (size_t i{}; i < fields.size(); i++) {
-      getline(fen_fields, fields[i], ' ');
-    }
-    board = GameBoard(fields[0]);
-    piece_list = board.get_piece_list();
-    const std::string_view turn_to_move = fields[1];
-    const std::string_view castling_rights = fields[2];
-    const std::string_view en_passant_square = fields[3];
-    const std::string_view halfmove_clock = fields[4];
-    const std::string_view fullmove_counter = fields[5];
-
-    set_castling_from_fen(castling_rights);
-
-    if (turn_to_move != "w" && turn_to_move != "b") {
-      throw std::runtime_error("Illegal FEN: turn must be 'w' or 'b");
+
+ChessGame::ChessGame(std::string_view fen)
+: ChessGame([fen] {
+    const auto position = Fen::parse(fen);
+    if (!position) {
+      throw std::runtime_error(std::format("Illegal FEN: {}", Fen::message(position.error())));
     }
-    if (en_passant_square != "-" && en_passant_square.size() == 2) {
-      char file = std::tolower(en_passant_square[0]);
-      char rank = std::tolower(en_passant_square[1]);
-      if (std::isalpha(file) && std::isdigit(rank)) {
-        state.en_passant_target_square = Square{static_cast<Rank>(rank - 1), static_cast<File>(file - 'a')};
-        state.passant_sqr_exists = true;
-      }
-    } else if (en_passant_square == "-") {
-      state.passant_sqr_exists = false;
-    } else {
-      throw std::runtime_error("En passant square has wrong format");
+    return *position;
+  }()) {}
+
+
+ChessGame::ChessGame(const Fen::Position& position)
+: move_gen(board) {
+  board.clear();
+  for (int sq = 0; sq < 64; ++sq) {
+    if (position.squares[sq].type != NoPiece) {
+      board.set_piece(position.squares[sq], to_square(sq));
     }
-    state.current_turn = turn_to_move == "w" ? White : Black;
-    state.half_move_clock = std::stoi(halfmove_clock.data());
-    state.full_moves = std::stoi(fullmove_counter.data());
-  } catch (std::runtime_error& e) {
-    throw std::runtime_error(std::format("{}:{}:{}:{}",
-      location.file_name(),
-      location.function_name(),
-      location.line(),
-      e.what()));
   }
+  const uint8_t rights = position.castling_rights;
+  state.current_turn = position.side_to_move;
+  state.k_rook_white_moved = !(rights & WhiteKingSide);
+  state.q_rook_white_moved = !(rights & WhiteQueenSide);
+  state.k_rook_black_moved = !(rights & BlackKingSide);
+  state.q_rook_black_moved = !(rights & BlackQueenSide);
+  if (position.en_passant) {
+    state.en_passant_target_square = *position.en_passant;
+    state.passant_sqr_exists = true;
+  }
+  state.half_move_clock = position.half_move_clock;
+  state.full_moves = position.full_moves;
+  state.key = compute_key();
+}
+
+
+void ChessGame::apply_move(PackedMove move) {
+  apply_move(move.to_move());
 }
 
 
 void ChessGame::apply_move(Move move) {
   prev_state.push_back(state);
+  const uint64_t board_key = board.key();
+  const uint64_t state_key = castling_and_en_passant_key();
   const auto[from_r, from_f] = move.from;
   state.passant_sqr_exists = false;
   Piece p = board.at(from_r, from_f);
+  const Piece captured = board.at(move.to);
+  const DirtySquares dirty = network ? dirty_squares(move) : DirtySquares{};
+  move_history.emplace_back(move, captured.type != NoPiece);
+  // A rook captured on its starting square takes that side's castling right with it
+  if (captured.type == Rook) {
+    update_castling_rights(captured, move.to);
+  }
   board.move_piece(p, move);
+  state.half_move_clock = p.type == Pawn || captured.type != NoPiece ? 0 : state.half_move_clock + 1;
   if (p.type == King || p.type == Rook) {
     if (move.is_castling()) {
       Move m  = get_rook_castle_move(move);
@@ -95,13 +138,163 @@ void ChessGame::apply_move(Move move) {
   } else {
     state.current_turn = Black;
   }
+  // The board keeps its own piece key, so its delta covers the castling rook and promotions
+  state.key ^= board_key ^ board.key()
+             ^ state_key ^ castling_and_en_passant_key()
+             ^ Zobrist::keys.black_to_move;
+  if (network) {
+    push_accumulator(dirty, p);
+  }
+  verify_key();
 }
 
 
 void ChessGame::undo_move() {
+  if (move_history.back().is_castling()) {
+    board.undo_last_move();
+  }
+  move_history.pop_back();
   board.undo_last_move();
   state = prev_state.back();
   prev_state.pop_back();
+  if (network) {
+    // A move made before set_network has no entry of its own, so rebuild from the board
+    if (accumulators.size() > 1) {
+      accumulators.pop_back();
+    } else {
+      network->refresh(accumulators.back(), White, board);
+      network->refresh(accumulators.back(), Black, board);
+    }
+  }
+  verify_key();
+}
+
+
+void ChessGame::set_network(const Nnue::Network* net) {
+  network = net;
+  accumulators.clear();
+  if (network) {
+    accumulators.reserve(256);
+    Nnue::Accumulator& acc = accumulators.emplace_back();
+    network->refresh(acc, White, board);
+    network->refresh(acc, Black, board);
+  }
+}
+
+
+int ChessGame::evaluate(PawnTable* pawns) const {
+  if (network) {
+    return network->evaluate(accumulators.back(), state.current_turn);
+  }
+  if (!pawns) {
+    return board.evaluate(state.current_turn);
+  }
+  Eval::Score score = board.psq_score();
+  score += pawns->probe(board.pawn_key(), board.pieces(White, Pawn), board.pieces(Black, Pawn)).score;
+  const int value = Eval::taper(score, board.game_phase());
+  return state.current_turn == Black ? -value : value;
+}
+
+
+ChessGame::DirtySquares ChessGame::dirty_squares(const Move& move) const {
+  DirtySquares dirty;
+  const auto add = [&](Square s) {
+    dirty.squares[dirty.count] = to_index(s);
+    dirty.before[dirty.count++] = board.at(s);
+  };
+  add(move.from);
+  add(move.to);
+  if (move.is_castling()) {
+    const Move rook = get_rook_castle_move(move);
+    add(rook.from);
+    add(rook.to);
+  } else if (move.is_en_passant) {
+    add(Square{move.from.rank, move.to.file});
+  }
+  return dirty;
+}
+
+
+void ChessGame::push_accumulator(const DirtySquares& dirty, Piece moved) {
+  accumulators.push_back(accumulators.back());
+  Nnue::Accumulator& acc = accumulators.back();
+  for (const Color perspective : {White, Black}) {
+    // Every feature is relative to the king, so a king move rebuilds its own side
+    if (moved.type == King && moved.color == perspective) {
+      network->refresh(acc, perspective, board);
+      continue;
+    }
+    const int king = to_index(board.king_square(perspective));
+    std::array<size_t, 4> added{};
+    std::array<size_t, 4> removed{};
+    size_t n_added = 0;
+    size_t n_removed = 0;
+    for (size_t i = 0; i < dirty.count; ++i) {
+      const int sq = dirty.squares[i];
+      const Piece before = dirty.before[i];
+      const Piece after = board.at(to_square(sq));
+      if (before.type == after.type && before.color == after.color) {
+        continue;
+      }
+      if (before.type != NoPiece && before.type != King) {
+        removed[n_removed++] = Nnue::feature_index(perspective, king, before, sq);
+      }
+      if (after.type != NoPiece && after.type != King) {
+        added[n_added++] = Nnue::feature_index(perspective, king, after, sq);
+      }
+    }
+    network->update(acc, perspective, std::span(added.data(), n_added), std::span(removed.data(), n_removed));
+  }
+}
+
+
+uint64_t ChessGame::compute_key() const {
+  uint64_t key = castling_and_en_passant_key();
+  for (const auto color : {White, Black}) {
+    for (const auto type : {Pawn, Knight, Bishop, Rook, Queen, King}) {
+      Bitboard b = board.pieces(color, type);
+      while (b) {
+        key ^= Zobrist::keys.piece_square[GameBoard::piece_index({type, color})][pop_lsb(b)];
+      }
+    }
+  }
+  if (state.current_turn == Black) {
+    key ^= Zobrist::keys.black_to_move;
+  }
+  return key;
+}
+
+
+uint8_t ChessGame::castling_rights() const {
+  uint8_t rights{};
+  if (!state.king_moved_w && !state.k_rook_white_moved) rights |= WhiteKingSide;
+  if (!state.king_moved_w && !state.q_rook_white_moved) rights |= WhiteQueenSide;
+  if (!state.king_moved_b && !state.k_rook_black_moved) rights |= BlackKingSide;
+  if (!state.king_moved_b && !state.q_rook_black_moved) rights |= BlackQueenSide;
+  return rights;
+}
+
+
+uint64_t ChessGame::castling_and_en_passant_key() const {
+  uint64_t key = Zobrist::keys.castling[castling_rights()];
+  if (state.passant_sqr_exists) {
+    key ^= Zobrist::keys.en_passant_file[state.en_passant_target_square.file];
+  }
+  return key;
+}
+
+
+/**
+ * With CHESS_DEBUG_HASH defined, throws when the incrementally maintained key has
+ * drifted from a full recomputation. Compiles to nothing otherwise.
+ */
+void ChessGame::verify_key() const {
+#ifdef CHESS_DEBUG_HASH
+  if (const uint64_t expected = compute_key(); state.key != expected) {
+    throw std::logic_error(std::format("Zobrist key mismatch: incremental {:#x}, recomputed {:#x}",
+      state.key, expected));
+  }
+#endif
 }
 
 
@@ -109,12 +302,7 @@ bool ChessGame::is_legal_move(Piece p, Move m) {
   board.move_piece(p, m);
   Square king_sqr{};
   if (p.type != King) {
-    for (const auto& [piece, square] : piece_list) {
-      if (piece.type == King && state.current_turn == piece.color) {
-        king_sqr = square;
-        break;
-      }
-    }
+    king_sqr = board.king_square(state.current_turn);
   } else {
     king_sqr = m.to;
     if (m.is_castling()) {
@@ -179,65 +367,77 @@ std::vector<Move> ChessGame::generate_legal_moves(Piece p, Square source) {
 }
 
 
-bool ChessGame::is_check(Square s) const {
-  const auto[curr_rank, curr_file] = s;
-  Color enemy_color = state.current_turn == White ? Black : White;
-  using AttackType = std::function<bool(std::initializer_list<PieceType> check_for, int curr_rank, int curr_file, int rank_dir, int file_dir)>;
-  AttackType sliding_attacks = [&] (std::initializer_list<PieceType> check_for, int rank, int file, int rank_dir, int file_dir) {
-    while (rank >= Rank_1 && rank <= Rank_8 && file >= File_A && file <= File_H) {
-      Piece p = board.at(static_cast<Rank>(rank), static_cast<File>(file));
-      if (p.color == enemy_color && std::ranges::find(check_for, p.type) != check_for.end()) {
-        return true;
-      }
-      if (p.color != NoColor) {
-        break;
-      }
-      rank += rank_dir;
-      file += file_dir;
-    }
-    return false;
-  };
+void ChessGame::generate_legal_moves(MoveList& list) {
+  MoveGenerator::generate_legal_moves(board, list, state.current_turn, castling_rights(), en_passant_square());
+}
 
-  AttackType regular_attacks = [&] (std::initializer_list<PieceType> check_for, int rank, int file, int rank_dir, int file_dir) {
-    if (!GameBoard::is_inbound(rank, file)) {
-      return false;
-    }
-    Piece p = board.at(static_cast<Rank>(rank), static_cast<File>(file));
-    if (p.color == enemy_color && std::ranges::find(check_for, p.type) != check_for.end()) {
-      return true;
-    }
-    return false;
-  };
 
-  auto check_for = [&] (std::initializer_list<PieceType> check_for_piece, std::span<const MoveDir> dir, AttackType c) {
-    return std::ranges::any_of(dir, [&] (const MoveDir& d) {
-      int new_rank = curr_rank + d.to_rank;
-      int new_file = curr_file + d.to_file;
-      return c(check_for_piece, new_rank, new_file, d.to_rank, d.to_file);
-    });
-  };
+std::optional<Square> ChessGame::en_passant_square() const {
+  return state.passant_sqr_exists ? std::optional{state.en_passant_target_square} : std::nullopt;
+}
 
-  int pawn_attack_dir = enemy_color == Black ? 1 : -1;
-  auto pawn_dirs = std::array{MoveDir{pawn_attack_dir, 1}, MoveDir{pawn_attack_dir, -1}};
-  if (check_for({Pawn}, pawn_dirs, regular_attacks)) {
-    return true;
-  }
-  if (check_for({Knight}, MoveGenerator::knight_dir, regular_attacks)) {
-    return true;
-  }
-  if (check_for({King}, MoveGenerator::king_directions, regular_attacks)) {
-    return true;
+
+PositionSnapshot ChessGame::snapshot() const {
+  return PositionSnapshot(board, state.current_turn, castling_rights(), en_passant_square(),
+    static_cast<uint16_t>(state.half_move_clock), static_cast<uint16_t>(state.full_moves), state.key);
+}
+
+
+std::string ChessGame::to_fen() const {
+  Fen::Position position;
+  for (int sq = 0; sq < 64; ++sq) {
+    position.squares[sq] = board.at(to_square(sq));
   }
-  if (check_for({Queen, Rook}, MoveGenerator::rook_directions, sliding_attacks)) {
+  position.side_to_move = state.current_turn;
+  position.castling_rights = castling_rights();
+  position.en_passant = en_passant_square();
+  position.half_move_clock = static_cast<uint16_t>(state.half_move_clock);
+  position.full_moves = static_cast<uint16_t>(state.full_moves);
+  return Fen::to_string(position);
+}
+
+
+bool ChessGame::is_check(Square s) const {
+  const Color enemy_color = state.current_turn == White ? Black : White;
+  return board.attackers_to(to_index(s), board.occupancy()) & board.pieces(enemy_color);
+}
+
+
+int ChessGame::see(PackedMove m) const {
+  return ::see(board, m);
+}
+
+
+bool ChessGame::see_ge(PackedMove m, int threshold) const {
+  return ::see_ge(board, m, threshold);
+}
+
+
+bool ChessGame::in_check() const {
+  return is_check(board.king_square(state.current_turn));
+}
+
+
+bool ChessGame::is_draw() const {
+  if (state.half_move_clock >= 100) {
     return true;
   }
-  if (check_for({Queen, Bishop}, MoveGenerator::bishop_directions, sliding_attacks)) {
-    return true;
+  // Only positions with the same side to move, after the last irreversible move, can repeat
+  const size_t plies = std::min(state.half_move_clock, prev_state.size());
+  for (size_t i = 2; i <= plies; i += 2) {
+    if (prev_state[prev_state.size() - i].key == state.key) {
+      return true;
+    }
   }
   return false;
 }
 
 
+Bitboard ChessGame::attacked_squares(Color by) const {
+  return board.attacked_squares(by);
+}
+
+
 bool ChessGame::can_enpassant(Piece piece, Square current_pos) const {
   assert(state.passant_sqr_exists == true);
   assert(piece.type == Pawn);
@@ -273,14 +473,14 @@ void ChessGame::update_castling_rights(Piece p, Square src) {
     }
   }
   //Cases where either sides rook has not moved
-  if (p.type == Rook && p.color == White) {
+  if (p.type == Rook && p.color == White && src.rank == Rank_1) {
     if (src.file == File_H) {
       state.k_rook_white_moved = true;
     } else if (src.file == File_A) {
       state.q_rook_white_moved = true;
     }
   }
-  if (p.type == Rook && p.color == Black) {
+  if (p.type == Rook && p.color == Black && src.rank == Rank_8) {
     if (src.file == File_H) {
       state.k_rook_black_moved = true;
     } else if (src.file == File_A) {
@@ -367,11 +567,11 @@ std::vector<Move> ChessGame::get_castling_squares(Square king_pos) {
 }
 
 
-Move ChessGame::get_rook_castle_move(const Move &kings_move) {
+Move ChessGame::get_rook_castle_move(const Move &kings_move) const {
   auto [king_pos_r, king_pos_f] = kings_move.to;
-  const Piece king = board.at(kings_move.from);
-  assert(king.type == King);
-  const Rank side = king.color == White ? Rank_1 : Rank_8;
+  // Called after the king has left its square, so the castling rank comes from the move itself
+  assert(kings_move.from.rank == Rank_1 || kings_move.from.rank == Rank_8);
+  const Rank side = kings_move.from.rank;
   const File rook_start = kings_move.is_k_castle ? File_H : File_A;
   const File rook_dest = kings_move.is_k_castle ? static_cast<File>(king_pos_f - 1) : static_cast<File>(king_pos_f + 1);
   const Move m{Square{side, rook_start}, Square{side, rook_dest} };
@@ -394,46 +594,13 @@ void ChessGame::update_en_passant_square(Square last_pawn_move, Color pawn_color
 }
 
 
-void ChessGame::set_castling_from_fen(const std::string_view f) {
-  const size_t len = f.length();
-  assert(f == "-" || (len >= 1 && len <= 4 && f != "-"));
-  bool can_castle = false;
-  for (const auto& c : f) {
-    switch (c) {
-      case 'K':
-        can_castle = true;
-      state.k_rook_white_moved = false;
-      break;
-      case 'Q':
-        can_castle = true;
-      state.q_rook_white_moved = false;
-      break;
-      case 'k':
-        can_castle = true;
-      state.k_rook_black_moved = false;
-      break;
-      case 'q':
-        can_castle = true;
-      state.q_rook_black_moved = false;
-      break;
-      case '-':
-        if (can_castle) {
-          throw std::runtime_error("Illegal fen: Cannot include '-' with characters");
-        }
-      return;
-      default:
-    }
-  }
-}
-
-
 Color ChessGame::get_current_turn() const {
   return state.current_turn;
 }
 
 
 const std::vector<std::pair<Piece, Square>>& ChessGame::get_piece_list() {
-  return piece_list;
+  return board.get_piece_list();
 }
 
 
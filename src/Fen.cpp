@@ -0,0 +1,230 @@
+#include <Fen.h>
+#include <algorithm>
+#include <charconv>
+
+namespace {
+  constexpr std::string_view piece_letters = "PNBRQK";
+  constexpr std::string_view whitespace = " \t";
+
+  // Removes and returns the next whitespace separated field of rest, empty once it is used up
+  std::string_view next_field(std::string_view& rest) {
+    const size_t start = std::min(rest.find_first_not_of(whitespace), rest.size());
+    rest.remove_prefix(start);
+    const size_t end = std::min(rest.find_first_of(whitespace), rest.size());
+    const std::string_view field = rest.substr(0, end);
+    rest.remove_prefix(end);
+    return field;
+  }
+
+  std::optional<Piece> letter_to_piece(char c) {
+    const bool black = c >= 'a' && c <= 'z';
+    const size_t type = piece_letters.find(black ? static_cast<char>(c - 'a' + 'A') : c);
+    if (type == std::string_view::npos) {
+      return std::nullopt;
+    }
+    return Piece{static_cast<PieceType>(type + 1), black ? Black : White};
+  }
+
+  char piece_to_letter(Piece p) {
+    const char c = piece_letters[p.type - 1];
+    return p.color == Black ? static_cast<char>(c - 'A' + 'a') : c;
+  }
+
+  bool parse_number(std::string_view field, uint16_t& value) {
+    const char* end = field.data() + field.size();
+    const auto [ptr, ec] = std::from_chars(field.data(), end, value);
+    return !field.empty() && ec == std::errc{} && ptr == end;
+  }
+
+  std::expected<uint8_t, Fen::Error> parse_castling(std::string_view field) {
+    if (field == "-") {
+      return 0;
+    }
+    uint8_t rights = 0;
+    for (const char c : field) {
+      const size_t i = std::string_view("KQkq").find(c);
+      if (i == std::string_view::npos || (rights >> i & 1)) {
+        return std::unexpected(Fen::Error::Castling);
+      }
+      rights |= static_cast<uint8_t>(1u << i);
+    }
+    if (!rights) {
+      return std::unexpected(Fen::Error::Castling);
+    }
+    return rights;
+  }
+
+  bool holds(const Fen::Squares& squares, int sq, PieceType type, Color color) {
+    const Piece p = squares[static_cast<size_t>(sq)];
+    return p.type == type && p.color == color;
+  }
+
+  // Keeps only the rights whose king and rook still stand on their home squares
+  uint8_t playable_castling(const Fen::Squares& squares, uint8_t rights) {
+    uint8_t playable = 0;
+    for (const Color c : {White, Black}) {
+      const int home = c == White ? 0 : 56;
+      const uint8_t king_side = c == White ? WhiteKingSide : BlackKingSide;
+      const uint8_t queen_side = c == White ? WhiteQueenSide : BlackQueenSide;
+      if (!holds(squares, home + 4, King, c)) {
+        continue;
+      }
+      if ((rights & king_side) && holds(squares, home + 7, Rook, c)) {
+        playable |= king_side;
+      }
+      if ((rights & queen_side) && holds(squares, home, Rook, c)) {
+        playable |= queen_side;
+      }
+    }
+    return playable;
+  }
+
+  // True when target is behind a pawn of the side not to move that could just have pushed two squares
+  bool playable_en_passant(const Fen::Squares& squares, Square target, Color side_to_move) {
+    const Color them = side_to_move == White ? Black : White;
+    const Rank rank = side_to_move == White ? Rank_6 : Rank_3;
+    const int pawn = to_index(target) + (side_to_move == White ? -8 : 8);
+    return target.rank == rank && holds(squares, pawn, Pawn, them);
+  }
+}
+
+namespace Fen {
+  std::string_view message(Error error) {
+    switch (error) {
+      case Error::MissingField: return "expected at least 4 fields";
+      case Error::PiecePlacement: return "piece placement needs 8 ranks of 8 squares using pnbrqkPNBRQK and 1-8, with no pawn on rank 1 or 8";
+      case Error::SideToMove: return "side to move must be w or b";
+      case Error::Castling: return "castling field must be - or a subset of KQkq";
+      case Error::EnPassant: return "en passant field must be - or a square on rank 3 or 6";
+      case Error::HalfMoveClock: return "half move clock must be a number up to 65535";
+      case Error::FullMoveNumber: return "full move number must follow the half move clock and be a number up to 65535";
+      case Error::TrailingInput: return "unexpected input after the full move number";
+    }
+    return "unknown error";
+  }
+
+  std::expected<Squares, Error> parse_placement(std::string_view placement) {
+    Squares squares{};
+    int rank = Rank_8;
+    int file = File_A;
+    for (const char c : placement) {
+      if (c == '/') {
+        if (file != 8 || rank == Rank_1) {
+          return std::unexpected(Error::PiecePlacement);
+        }
+        --rank;
+        file = File_A;
+      } else if (c >= '1' && c <= '8') {
+        file += c - '0';
+      } else if (const auto p = letter_to_piece(c); p && file < 8) {
+        // No legal position has a pawn on a back rank, and move generation assumes none
+        if (p->type == Pawn && (rank == Rank_1 || rank == Rank_8)) {
+          return std::unexpected(Error::PiecePlacement);
+        }
+        squares[static_cast<size_t>(rank * 8 + file++)] = *p;
+      } else {
+        return std::unexpected(Error::PiecePlacement);
+      }
+      if (file > 8) {
+        return std::unexpected(Error::PiecePlacement);
+      }
+    }
+    if (rank != Rank_1 || file != 8) {
+      return std::unexpected(Error::PiecePlacement);
+    }
+    return squares;
+  }
+
+  std::expected<Position, Error> parse(std::string_view fen) {
+    const std::string_view placement = next_field(fen);
+    const std::string_view side = next_field(fen);
+    const std::string_view castling = next_field(fen);
+    const std::string_view en_passant = next_field(fen);
+    const std::string_view half_moves = next_field(fen);
+    const std::string_view full_moves = next_field(fen);
+    if (en_passant.empty()) {
+      return std::unexpected(Error::MissingField);
+    }
+
+    Position position;
+    const auto squares = parse_placement(placement);
+    if (!squares) {
+      return std::unexpected(squares.error());
+    }
+    position.squares = *squares;
+    if (side != "w" && side != "b") {
+      return std::unexpected(Error::SideToMove);
+    }
+    position.side_to_move = side == "w" ? White : Black;
+    const auto rights = parse_castling(castling);
+    if (!rights) {
+      return std::unexpected(rights.error());
+    }
+    position.castling_rights = playable_castling(position.squares, *rights);
+    if (en_passant != "-") {
+      if (en_passant.size() != 2 || en_passant[0] < 'a' || en_passant[0] > 'h'
+          || (en_passant[1] != '3' && en_passant[1] != '6')) {
+        return std::unexpected(Error::EnPassant);
+      }
+      const Square target{static_cast<Rank>(en_passant[1] - '1'), static_cast<File>(en_passant[0] - 'a')};
+      if (playable_en_passant(position.squares, target, position.side_to_move)) {
+        position.en_passant = target;
+      }
+    }
+    if (!half_moves.empty()) {
+      if (!parse_number(half_moves, position.half_move_clock)) {
+        return std::unexpected(Error::HalfMoveClock);
+      }
+      if (!parse_number(full_moves, position.full_moves)) {
+        return std::unexpected(Error::FullMoveNumber);
+      }
+    }
+    if (!next_field(fen).empty()) {
+      return std::unexpected(Error::TrailingInput);
+    }
+    return position;
+  }
+
+  std::string to_string(const Position& position) {
+    std::string fen;
+    fen.reserve(96);
+    for (int rank = Rank_8; rank >= Rank_1; --rank) {
+      int empty = 0;
+      for (int file = File_A; file <= File_H; ++file) {
+        const Piece p = position.squares[static_cast<size_t>(rank * 8 + file)];
+        if (p.type == NoPiece) {
+          ++empty;
+          continue;
+        }
+        if (empty) {
+          fen += static_cast<char>('0' + empty);
+          empty = 0;
+        }
+        fen += piece_to_letter(p);
+      }
+      if (empty) {
+        fen += static_cast<char>('0' + empty);
+      }
+      if (rank != Rank_1) {
+        fen += '/';
+      }
+    }
+
+    fen += position.side_to_move == Black ? " b " : " w ";
+    if (!position.castling_rights) {
+      fen += '-';
+    }
+    for (size_t i = 0; i < 4; ++i) {
+      if (position.castling_rights & (1u << i)) {
+        fen += "KQkq"[i];
+      }
+    }
+    fen += ' ';
+    fen += position.en_passant ? position.en_passant->to_string() : "-";
+    fen += ' ';
+    fen += std::to_string(position.half_move_clock);
+    fen += ' ';
+    fen += std::to_string(position.full_moves);
+    return fen;
+  }
+}
@@ -3,19 +3,22 @@
 //
 
 #include <GameTypes.h>
+#include <Fen.h>
 #include <cassert>
 #include <iostream>
+#include <stdexcept>
 #include <utility>
 
 GameBoard::GameBoard() {
   set_initial_board();
 }
 
-GameBoard::GameBoard(std::string fen_str) :
-piece_list(load_from_fen_piece_placement(std::move(fen_str))){}
+GameBoard::GameBoard(std::string_view placement) {
+  load_from_fen_piece_placement(placement);
+}
 
 void GameBoard::set_initial_board() {
-  static std::vector<std::pair<Piece, Square>> pieces =
+  static const std::vector<std::pair<Piece, Square>> pieces =
   {
     {Piece {Rook, White}, Square{Rank_1, File_A}},
     {Piece {Rook, White}, Square{Rank_1, File_H}},
@@ -35,20 +38,17 @@ void GameBoard::set_initial_board() {
     {Piece {Queen, White}, Square {Rank_1, File_D}}
   };
 
-  for (size_t i = File_A; i <= File_H; i++) {
-    Piece white_pawn{Pawn, White};
-    Piece black_pawn{Pawn, Black};
-    pieces.push_back({white_pawn, {Rank_2, static_cast<File>(i)}});
-    pieces.push_back({black_pawn, {Rank_7, static_cast<File>(i)}});
-  }
   for (const auto& p : pieces) {
-    piece_list.push_back(p);
     set_piece(p.first, p.second);
   }
+  for (size_t i = File_A; i <= File_H; i++) {
+    set_piece(Piece{Pawn, White}, {Rank_2, static_cast<File>(i)});
+    set_piece(Piece{Pawn, Black}, {Rank_7, static_cast<File>(i)});
+  }
 }
 
 Piece GameBoard::at(const Rank r, const File f) const {
-  u_int8_t piece = board[r][f];
+  u_int8_t piece = board[r * 8 + f];
   return {
     static_cast<PieceType>(piece & 0x7),
     static_cast<Color>(piece & 0b11000)
@@ -56,7 +56,7 @@ Piece GameBoard::at(const Rank r, const File f) const {
 };
 
 Piece GameBoard::at(Square s) const {
-  u_int8_t piece = board[s.rank][s.file];
+  u_int8_t piece = board[to_index(s)];
   return {
     static_cast<PieceType>(piece & 0x7),
     static_cast<Color>(piece & 0b11000)
@@ -67,26 +67,65 @@ Piece GameBoard::piece_at(Square s) const {
   if (!is_inbound(s.rank, s.file)) {
     return {NoPiece, NoColor};
   }
-  auto [rank, file] = s;
-  const auto pos = std::find_if(piece_list.begin(), piece_list.end(), [&](const Position& var) {
-    auto [target_r, target_f] = var.second;
-    return rank == target_r && file == target_f;
-  });
-  if (pos == piece_list.end()) {
-    return {NoPiece, NoColor};
+  return at(s);
+}
+
+Bitboard GameBoard::pieces(Color c, PieceType t) const {
+  return piece_bb[piece_index({t, c})];
+}
+
+Bitboard GameBoard::pieces(Color c) const {
+  return color_bb[color_index(c)];
+}
+
+Bitboard GameBoard::pieces(PieceType t) const {
+  return pieces(White, t) | pieces(Black, t);
+}
+
+Bitboard GameBoard::attackers_to(int sq, Bitboard occupied) const {
+  return (pawn_attacks(1, sq) & pieces(White, Pawn))
+       | (pawn_attacks(0, sq) & pieces(Black, Pawn))
+       | (knight_attacks(sq) & pieces(Knight))
+       | (king_attacks(sq) & pieces(King))
+       | (bishop_attacks(sq, occupied) & (pieces(Bishop) | pieces(Queen)))
+       | (rook_attacks(sq, occupied) & (pieces(Rook) | pieces(Queen)));
+}
+
+Bitboard GameBoard::attacked_squares(Color c) const {
+  const Bitboard occupied = occupancy();
+  const Bitboard pawns = pieces(c, Pawn);
+  Bitboard attacked = c == White
+    ? ((pawns & ~FileABB) << 7) | ((pawns & ~FileHBB) << 9)
+    : ((pawns & ~FileABB) >> 9) | ((pawns & ~FileHBB) >> 7);
+
+  Bitboard b = pieces(c, Knight);
+  while (b) {
+    attacked |= knight_attacks(pop_lsb(b));
+  }
+  b = pieces(c, Bishop) | pieces(c, Queen);
+  while (b) {
+    attacked |= bishop_attacks(pop_lsb(b), occupied);
   }
-  return pos->first;
+  b = pieces(c, Rook) | pieces(c, Queen);
+  while (b) {
+    attacked |= rook_attacks(pop_lsb(b), occupied);
+  }
+  b = pieces(c, King);
+  while (b) {
+    attacked |= king_attacks(pop_lsb(b));
+  }
+  return attacked;
 }
 
-void GameBoard::update_piece_position(Square from, Square to) {
-  auto piece_position = std::find_if(piece_list.begin(), piece_list.end(), [&] (Position& var) {
-    auto [target_r, target_f] = var.second;
-    return from.rank == target_r && from.file == target_f;
-  });
-  assert(piece_position != piece_list.end());
-  piece_position->second = to;
+Bitboard GameBoard::occupancy() const {
+  return color_bb[0] | color_bb[1];
 }
 
+Square GameBoard::king_square(Color c) const {
+  const Bitboard king = pieces(c, King);
+  assert(king);
+  return to_square(lsb(king));
+}
 
 bool GameBoard::is_regular_capture(const Piece p, Square to_square) {
   Color enemy_color = p.color == White ? Black : White;
@@ -100,14 +139,11 @@ bool GameBoard::undo_last_move() {
   if (move_history.empty()) {
     return false;
   }
-  auto [move, was_captured, captured_square] = move_history.back();
-  Piece p = at(move.to);
-  clear_piece(move.to);
-  set_piece(p, move.from);
-  update_piece_position(move.to, move.from);
+  const auto& [move, moved, was_captured, captured_square] = move_history.back();
+  clear_piece(to_square(move.to()));
+  set_piece(moved, to_square(move.from()));
   if (was_captured.type != NoPiece) {
     set_piece(was_captured, captured_square);
-    piece_list.emplace_back(was_captured, captured_square);
   }
   move_history.pop_back();
   return true;
@@ -118,20 +154,29 @@ bool GameBoard::is_inbound(const int r, const int f) {
 }
 
 bool GameBoard::capture_piece(Square s) {
-  if (!clear_piece(s)) {
+  if (!is_inbound(s.rank, s.file) || at(s).type == NoPiece) {
     return false;
   }
-  return std::erase_if(piece_list, [&](Position& var) {
-      auto [target_r, target_f] = var.second;
-      return s.rank == target_r && s.file == target_f;
-  });
+  return clear_piece(s);
 }
 
 bool GameBoard::clear_piece(Square s) {
   if (auto [r, f] = s; !is_inbound(r,f)) {
     return false;
   }
-  board[s.rank][s.file] = 0;
+  const int idx = to_index(s);
+  const Piece old = intToPiece(board[idx]);
+  if (old.type != NoPiece) {
+    piece_bb[piece_index(old)] &= ~square_bb(idx);
+    color_bb[color_index(old.color)] &= ~square_bb(idx);
+    hash ^= Zobrist::keys.piece_square[piece_index(old)][idx];
+    psq -= Eval::psqt[piece_index(old)][idx];
+    if (old.type == Pawn) {
+      pawn_hash ^= Zobrist::keys.piece_square[piece_index(old)][idx];
+    }
+    phase -= Eval::phase_weight[old.type];
+  }
+  board[idx] = 0;
   return true;
 }
 
@@ -141,27 +186,26 @@ bool GameBoard::move_piece(const Piece p, Move m) {
   if (!is_inbound(dest_r, dest_f) || !is_inbound(from_r, from_f)) {
     return false;
   }
-  if (board[from_r][from_f] == 0) {
+  if (board[to_index(m.from)] == 0) {
     return false;
   }
-  move_history.emplace_back(
-    MoveChange{Move{m.from, m.to},Piece{NoPiece, NoColor}}
+  MoveChange& change = move_history.emplace_back(
+    MoveChange{PackedMove{to_index(m.from), to_index(m.to), MoveFlag::Quiet}, at(m.from), Piece{NoPiece, NoColor}, m.to}
   );
   if (is_regular_capture(p, m.to)) {
-    move_history.back().was_captured = piece_at(m.to);
-    move_history.back().captured_square = m.to;
-    capture_piece(m.to);
+    change.was_captured = at(m.to);
+    change.captured_square = m.to;
+    clear_piece(m.to);
   } else if (m.is_en_passant) {
     assert(p.type == Pawn);
     const int dir = p.color == White ? -1 : 1;
     const Square en_passant_captured_square {static_cast<Rank>(m.to.rank + dir), m.to.file};
-    move_history.back().was_captured = piece_at(en_passant_captured_square);
-    move_history.back().captured_square = en_passant_captured_square;
-    capture_piece(en_passant_captured_square);
+    change.was_captured = at(en_passant_captured_square);
+    change.captured_square = en_passant_captured_square;
+    clear_piece(en_passant_captured_square);
   }
   clear_piece(m.from);
   set_piece(p, m.to);
-  update_piece_position(m.from, m.to);
   return true;
 }
 
@@ -169,39 +213,57 @@ bool GameBoard::set_piece(Piece p, Square s) {
   if (!is_inbound(s.rank, s.file)) {
     return false;
   }
-  board[s.rank][s.file] = piece(p.color, p.type);
+  clear_piece(s);
+  if (p.type == NoPiece) {
+    return true;
+  }
+  const int idx = to_index(s);
+  piece_bb[piece_index(p)] |= square_bb(idx);
+  color_bb[color_index(p.color)] |= square_bb(idx);
+  hash ^= Zobrist::keys.piece_square[piece_index(p)][idx];
+  psq += Eval::psqt[piece_index(p)][idx];
+  if (p.type == Pawn) {
+    pawn_hash ^= Zobrist::keys.piece_square[piece_index(p)][idx];
+  }
+  phase += Eval::phase_weight[p.type];
+  board[idx] = piece(p.color, p.type);
   return true;
 }
 
-std::vector<std::pair<Piece, Square>> GameBoard::load_from_fen_piece_placement(std::string fen) {
-  std::memset(board.data(), 0, sizeof(board));
-  std::stringstream b{fen};
-  std::vector<std::string> ranks;
-  std::vector<std::pair<Piece, Square>> piece_list;
-  std::string r;
-  std::cout << fen << std::endl;
-  while (std::getline(b, r, '/')) {
-    ranks.push_back(std::move(r));
+void GameBoard::clear() {
+  board.fill(0);
+  piece_bb.fill(0);
+  color_bb.fill(0);
+  hash = 0;
+  pawn_hash = 0;
+  psq = {};
+  phase = 0;
+  move_history.clear();
+}
+
+void GameBoard::load_from_fen_piece_placement(std::string_view placement) {
+  const auto squares = Fen::parse_placement(placement);
+  if (!squares) {
+    throw std::runtime_error(std::string(Fen::message(squares.error())));
   }
-  assert(ranks.size() == 8);
-  std::reverse(ranks.begin(), ranks.end());
-  for (int i{}; i < ranks.size(); i++) {
-    std::string_view rank = ranks[i];
-    size_t file{};
-    for (const auto& c : rank) {
-      if (isdigit(c)) {
-        file += c - '0';
-      } else {
-        piece_list.emplace_back(
-          std::make_pair<Piece, Square>(char_to_piece(c), {static_cast<Rank>(i), static_cast<File>(file)})
-          );
-        set_piece(piece_list.back().first, piece_list.back().second);
-        ++file;
-      }
+  clear();
+  for (int sq = 0; sq < 64; ++sq) {
+    if ((*squares)[sq].type != NoPiece) {
+      set_piece((*squares)[sq], to_square(sq));
     }
   }
+}
 
-  return piece_list;
+std::string PackedMove::to_string() const {
+  std::string uci = to_square(from()).to_string() + to_square(to()).to_string();
+  switch (promotion_piece()) {
+    case Knight: uci += 'n'; break;
+    case Bishop: uci += 'b'; break;
+    case Rook:   uci += 'r'; break;
+    case Queen:  uci += 'q'; break;
+    default: break;
+  }
+  return uci;
 }
 
 Piece GameBoard::intToPiece(u_int8_t pos) {
@@ -216,7 +278,7 @@ std::string GameBoard::to_fen_piece_placement() const {
   for (int rank = Rank_8; rank >= Rank_1; --rank) {
     int empty = 0;
     for (size_t file = File_A; file <= File_H; ++file) {
-      uint8_t p = board[rank][file];
+      uint8_t p = board[rank * 8 + file];
       if (p == 0) {
         ++empty;
       } else {
@@ -283,6 +345,14 @@ Piece GameBoard::char_to_piece(char c) {
 }
 
 std::vector<Position> &GameBoard::get_piece_list() {
+  piece_list.clear();
+  for (const Bitboard side : color_bb) {
+    Bitboard b = side;
+    while (b) {
+      const Square s = to_square(pop_lsb(b));
+      piece_list.emplace_back(at(s), s);
+    }
+  }
   return piece_list;
 }
 
@@ -0,0 +1,143 @@
+#include <Kpk.h>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+  // Bit flags, so the results of all moves from a position can be or-ed together
+  enum Result : uint8_t {
+    Invalid = 0,
+    Unknown = 1,
+    Draw = 2,
+    Win = 4
+  };
+
+  // Strong side is white and moves when stm is 0
+  size_t index(int stm, int weak_king, int strong_king, int pawn) {
+    const int pawn_slot = ((pawn >> 3) - 1) * 4 + (pawn & 7);
+    return static_cast<size_t>(stm | weak_king << 1 | strong_king << 7 | pawn_slot << 13);
+  }
+
+  int distance(int a, int b) {
+    return std::max(std::abs((a >> 3) - (b >> 3)), std::abs((a & 7) - (b & 7)));
+  }
+
+  bool wins_after_promotion(int strong_king, int pawn, int weak_king) {
+    const int promotion = pawn + 8;
+    if (promotion == strong_king || promotion == weak_king) {
+      return false;
+    }
+    if (distance(weak_king, promotion) == 1 && distance(strong_king, promotion) > 1) {
+      return false;
+    }
+    // A queen that stalemates may still win as a rook
+    const Bitboard occupied = square_bb(strong_king) | square_bb(promotion);
+    for (const Bitboard piece_attacks : {queen_attacks(promotion, occupied), rook_attacks(promotion, occupied)}) {
+      const Bitboard attacked = piece_attacks | king_attacks(strong_king);
+      if ((attacked & square_bb(weak_king)) || (king_attacks(weak_king) & ~attacked)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  Result initial_result(size_t idx) {
+    const int stm = static_cast<int>(idx & 1);
+    const int weak_king = static_cast<int>(idx >> 1 & 63);
+    const int strong_king = static_cast<int>(idx >> 7 & 63);
+    const int slot = static_cast<int>(idx >> 13);
+    const int pawn = (slot / 4 + 1) * 8 + slot % 4;
+
+    if (distance(strong_king, weak_king) <= 1 || pawn == strong_king || pawn == weak_king
+        || (stm == 0 && (pawn_attacks(0, pawn) & square_bb(weak_king)))) {
+      return Invalid;
+    }
+    if (stm == 0) {
+      return pawn >> 3 == Rank_7 && wins_after_promotion(strong_king, pawn, weak_king) ? Win : Unknown;
+    }
+    const Bitboard defended = king_attacks(strong_king) | pawn_attacks(0, pawn);
+    const Bitboard flights = king_attacks(weak_king) & ~defended;
+    if (flights & square_bb(pawn)) {
+      return Draw;
+    }
+    if (!flights) {
+      return pawn_attacks(0, pawn) & square_bb(weak_king) ? Win : Draw;
+    }
+    return Unknown;
+  }
+
+  Result classify(const std::vector<uint8_t>& results, size_t idx) {
+    const int stm = static_cast<int>(idx & 1);
+    const int weak_king = static_cast<int>(idx >> 1 & 63);
+    const int strong_king = static_cast<int>(idx >> 7 & 63);
+    const int slot = static_cast<int>(idx >> 13);
+    const int pawn = (slot / 4 + 1) * 8 + slot % 4;
+
+    // Moves into check, onto an occupied square or next to the other king index invalid positions
+    uint8_t reachable = Invalid;
+    Bitboard moves = king_attacks(stm == 0 ? strong_king : weak_king);
+    while (moves) {
+      const int to = pop_lsb(moves);
+      reachable |= results[stm == 0 ? index(1, weak_king, to, pawn) : index(0, to, strong_king, pawn)];
+    }
+    if (stm == 0 && pawn >> 3 < Rank_7) {
+      reachable |= results[index(1, weak_king, strong_king, pawn + 8)];
+      if (pawn >> 3 == Rank_2 && pawn + 8 != strong_king && pawn + 8 != weak_king) {
+        reachable |= results[index(1, weak_king, strong_king, pawn + 16)];
+      }
+    }
+
+    const Result good = stm == 0 ? Win : Draw;
+    const Result bad = stm == 0 ? Draw : Win;
+    if (reachable & good) {
+      return good;
+    }
+    return reachable & Unknown ? Unknown : bad;
+  }
+
+  using Bitbase = std::array<uint64_t, Kpk::position_count / 64>;
+
+  Bitbase generate() {
+    std::vector<uint8_t> results(Kpk::position_count);
+    for (size_t i = 0; i < results.size(); ++i) {
+      results[i] = initial_result(i);
+    }
+    // Each pass settles the positions one more move from a known result
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i] == Unknown && (results[i] = classify(results, i)) != Unknown) {
+          changed = true;
+        }
+      }
+    }
+    // Positions still unknown can be held forever by the weak side
+    Bitbase bitbase{};
+    for (size_t i = 0; i < results.size(); ++i) {
+      if (results[i] == Win) {
+        bitbase[i / 64] |= 1ULL << (i % 64);
+      }
+    }
+    return bitbase;
+  }
+}
+
+namespace Kpk {
+  bool probe(Color strong, int strong_king, int pawn, int weak_king, Color side_to_move) {
+    static const Bitbase bitbase = generate();
+    // Flip ranks so the pawn is white, then files so it is on a to d
+    if (strong == Black) {
+      strong_king ^= 56;
+      pawn ^= 56;
+      weak_king ^= 56;
+    }
+    if ((pawn & 7) > File_D) {
+      strong_king ^= 7;
+      pawn ^= 7;
+      weak_king ^= 7;
+    }
+    const size_t idx = index(side_to_move == strong ? 0 : 1, weak_king, strong_king, pawn);
+    return bitbase[idx / 64] >> (idx % 64) & 1;
+  }
+}
@@ -1,4 +1,5 @@
 #include <MoveGenerator.h>
+#include <PositionSnapshot.h>
 #include <cassert>
 #include <iostream>
 #include <algorithm>
@@ -127,15 +128,15 @@ std::vector<Square> MoveGenerator::generate_knight_pseudo_legal_moves(Piece p, S
 }
 
 std::vector<Square> MoveGenerator::generate_bishop_pseudo_legal_moves(Piece p, Square s) const {
-  return generate_sliding_moves(bishop_directions, p, s);
+  return to_squares(bishop_attacks(to_index(s), board.occupancy()) & ~board.pieces(p.color));
 }
 
 std::vector<Square> MoveGenerator::generate_rook_pseudo_legal_moves(Piece p, Square s) const {
-  return generate_sliding_moves(rook_directions, p, s);
+  return to_squares(rook_attacks(to_index(s), board.occupancy()) & ~board.pieces(p.color));
 }
 
 std::vector<Square> MoveGenerator::generate_queen_pseudo_legal_moves(Piece p, Square s) const {
-  return generate_sliding_moves(queen_directions, p, s);
+  return to_squares(queen_attacks(to_index(s), board.occupancy()) & ~board.pieces(p.color));
 }
 
 std::vector<Square> MoveGenerator::generate_king_pseudo_legal_moves(Piece p, Square s) const {
@@ -166,47 +167,305 @@ std::vector<Square> MoveGenerator::generate_king_pseudo_legal_moves(Piece p, Squ
   return moves;
 }
 
-template std::vector<Square>
-MoveGenerator::generate_sliding_moves<4>(
-    const std::array<MoveDir, 4>&,
-    Piece,
-    Square
-) const;
-
-template std::vector<Square>
-MoveGenerator::generate_sliding_moves<8>(
-    const std::array<MoveDir, 8>&,
-    Piece,
-    Square
-) const;
-
-template<size_t N>
-std::vector<Square> MoveGenerator::generate_sliding_moves
-(
-  const std::array<MoveDir, N> &dirs,
-  const Piece move,
-  const Square s) const
-{
-  std::vector<Square> moves{};
-  const auto[curr_rank, curr_file] = s;
-  Color enemy_color = move.color == White ? Black : White;
-  for (const auto& [rank_dir, file_dir] : dirs) {
-    int new_rank  = curr_rank + rank_dir;
-    int new_file = curr_file + file_dir;
-    while (new_rank >= Rank_1 && new_rank <= Rank_8 && new_file >= File_A && new_file <= File_H) {
-      Piece p = board.at(static_cast<Rank>(new_rank), static_cast<File>(new_file));
-      if (p.type == NoPiece) {
-        moves.push_back({static_cast<Rank>(new_rank), static_cast<File>(new_file)});
-      } else {
-        if (p.color == enemy_color) {
-          moves.push_back({static_cast<Rank>(new_rank), static_cast<File>(new_file)});
+std::vector<Square> MoveGenerator::to_squares(Bitboard b) {
+  std::vector<Square> moves;
+  moves.reserve(popcount(b));
+  while (b) {
+    moves.push_back(to_square(pop_lsb(b)));
+  }
+  return moves;
+}
+
+template<typename B>
+void MoveGenerator::generate_pawn_moves(const B& board, MoveList& list, Color us, Bitboard target,
+                                        std::optional<Square> en_passant) {
+  const int side = us == White ? 0 : 1;
+  const int up = us == White ? 8 : -8;
+  const Bitboard start_rank = us == White ? Rank2BB : Rank7BB;
+  const Bitboard promotion_rank = us == White ? Rank8BB : Rank1BB;
+  const Bitboard occupied = board.occupancy();
+  const Bitboard enemies = board.pieces(us == White ? Black : White);
+
+  Bitboard pawns = board.pieces(us, Pawn);
+  while (pawns) {
+    const int from = pop_lsb(pawns);
+    Bitboard dests = pawn_attacks(side, from) & enemies;
+    const int one_forward = from + up;
+    if (!(occupied & square_bb(one_forward))) {
+      dests |= square_bb(one_forward);
+      if ((start_rank & square_bb(from)) && !(occupied & square_bb(one_forward + up))) {
+        dests |= square_bb(one_forward + up);
+      }
+    }
+    dests &= target;
+    while (dests) {
+      const int to = pop_lsb(dests);
+      const bool capture = enemies & square_bb(to);
+      if (promotion_rank & square_bb(to)) {
+        const MoveFlag base = capture ? MoveFlag::KnightPromotionCapture : MoveFlag::KnightPromotion;
+        for (const auto promote_to : {Queen, Rook, Bishop, Knight}) {
+          list.push_back(PackedMove{from, to, static_cast<MoveFlag>(static_cast<int>(base) + promote_to - Knight)});
         }
-        break;
+      } else {
+        list.push_back(PackedMove{from, to, capture ? MoveFlag::Capture : MoveFlag::Quiet});
+      }
+    }
+    if (en_passant) {
+      const int ep = to_index(*en_passant);
+      if ((pawn_attacks(side, from) & square_bb(ep)) && (target & (square_bb(ep) | square_bb(ep - up)))) {
+        list.push_back(PackedMove{from, ep, MoveFlag::EnPassant});
       }
-      new_rank += rank_dir;
-      new_file += file_dir;
     }
   }
-  return moves;
 }
 
+template<typename B>
+void MoveGenerator::generate_piece_moves(const B& board, MoveList& list, Color us, PieceType t, Bitboard target) {
+  const Bitboard occupied = board.occupancy();
+  const Bitboard enemies = board.pieces(us == White ? Black : White);
+  Bitboard pieces = board.pieces(us, t);
+  while (pieces) {
+    const int from = pop_lsb(pieces);
+    Bitboard dests{};
+    switch (t) {
+      case Knight: dests = knight_attacks(from); break;
+      case Bishop: dests = bishop_attacks(from, occupied); break;
+      case Rook:   dests = rook_attacks(from, occupied); break;
+      case Queen:  dests = queen_attacks(from, occupied); break;
+      case King:   dests = king_attacks(from); break;
+      default:     assert(false);
+    }
+    dests &= target;
+    while (dests) {
+      const int to = pop_lsb(dests);
+      list.push_back(PackedMove{from, to, (enemies & square_bb(to)) ? MoveFlag::Capture : MoveFlag::Quiet});
+    }
+  }
+}
+
+template<typename B>
+void MoveGenerator::generate_castling_moves(const B& board, MoveList& list, Color us, uint8_t castling_rights,
+                                            const CheckInfo& info) {
+  const Color them = us == White ? Black : White;
+  const uint8_t king_side = us == White ? WhiteKingSide : BlackKingSide;
+  const uint8_t queen_side = us == White ? WhiteQueenSide : BlackQueenSide;
+  const Bitboard occupied = board.occupancy();
+  const Bitboard rooks = board.pieces(us, Rook);
+  const int k = info.king_sqr;
+  // Rights can outlive the pieces when a position was set up by hand, so check the board too
+  if (k != (us == White ? 4 : 60)) {
+    return;
+  }
+  auto attacked = [&] (int sq) {
+    return board.attackers_to(sq, occupied) & board.pieces(them);
+  };
+
+  if ((castling_rights & king_side) && (rooks & square_bb(k + 3))
+      && !(occupied & (square_bb(k + 1) | square_bb(k + 2))) && !attacked(k + 1) && !attacked(k + 2)) {
+    list.push_back(PackedMove{k, k + 2, MoveFlag::KingCastle});
+  }
+  if ((castling_rights & queen_side) && (rooks & square_bb(k - 4))
+      && !(occupied & (square_bb(k - 1) | square_bb(k - 2) | square_bb(k - 3)))
+      && !attacked(k - 1) && !attacked(k - 2)) {
+    list.push_back(PackedMove{k, k - 2, MoveFlag::QueenCastle});
+  }
+}
+
+template<typename B>
+MoveGenerator::CheckInfo MoveGenerator::get_check_info(const B& board, Color us) {
+  const Color them = us == White ? Black : White;
+  const int king_sqr = lsb(board.pieces(us, King));
+  const Bitboard occupied = board.occupancy();
+
+  Bitboard pinned{};
+  Bitboard snipers = ((rook_attacks(king_sqr, 0) & (board.pieces(them, Rook) | board.pieces(them, Queen)))
+                    | (bishop_attacks(king_sqr, 0) & (board.pieces(them, Bishop) | board.pieces(them, Queen))));
+  while (snipers) {
+    const Bitboard blockers = between_bb(king_sqr, pop_lsb(snipers)) & occupied;
+    if (popcount(blockers) == 1) {
+      pinned |= blockers & board.pieces(us);
+    }
+  }
+  return {king_sqr, board.attackers_to(king_sqr, occupied) & board.pieces(them), pinned};
+}
+
+template<typename B>
+bool MoveGenerator::is_legal(const B& board, Color us, PackedMove m, const CheckInfo& info) {
+  const Color them = us == White ? Black : White;
+  const int from = m.from();
+  const int to = m.to();
+
+  if (m.is_en_passant()) {
+    // The capture empties two squares on the king's rank or diagonal, so check the sliders directly
+    const int captured = (from & ~7) | (to & 7);
+    const Bitboard occupied = (board.occupancy() ^ square_bb(from) ^ square_bb(captured)) | square_bb(to);
+    return !(rook_attacks(info.king_sqr, occupied) & (board.pieces(them, Rook) | board.pieces(them, Queen)))
+        && !(bishop_attacks(info.king_sqr, occupied) & (board.pieces(them, Bishop) | board.pieces(them, Queen)));
+  }
+  if (from == info.king_sqr) {
+    // Castling transit squares were checked when the move was generated
+    if (m.is_castling()) {
+      return true;
+    }
+    // Lift the king off the board so a slider's ray reaches through its old square
+    const Bitboard occupied = board.occupancy() ^ square_bb(from);
+    return !(board.attackers_to(to, occupied) & board.pieces(them));
+  }
+  return !(info.pinned & square_bb(from)) || aligned(from, to, info.king_sqr);
+}
+
+template<typename B>
+bool MoveGenerator::is_pseudo_legal(const B& board, Color us, PackedMove m, uint8_t castling_rights,
+                                    std::optional<Square> en_passant, const CheckInfo& info) {
+  const Color them = us == White ? Black : White;
+  const int from = m.from();
+  const int to = m.to();
+  if (!m || !(board.pieces(us) & square_bb(from)) || (board.pieces(us) & square_bb(to))) {
+    return false;
+  }
+
+  if (m.is_castling()) {
+    if (info.checkers || from != info.king_sqr) {
+      return false;
+    }
+    MoveList castles;
+    generate_castling_moves(board, castles, us, castling_rights, info);
+    return std::ranges::find(castles, m) != castles.end();
+  }
+
+  PieceType t = Pawn;
+  while (!(board.pieces(us, t) & square_bb(from))) {
+    t = static_cast<PieceType>(t + 1);
+  }
+  if (popcount(info.checkers) > 1 && t != King) {
+    return false;
+  }
+  const Bitboard target = info.checkers && t != King
+    ? between_bb(info.king_sqr, lsb(info.checkers)) | info.checkers
+    : ~board.pieces(us);
+
+  const Bitboard occupied = board.occupancy();
+  const bool capture = board.pieces(them) & square_bb(to);
+  const MoveFlag plain_flag = capture ? MoveFlag::Capture : MoveFlag::Quiet;
+  if (t == Pawn) {
+    const int side = us == White ? 0 : 1;
+    const int up = us == White ? 8 : -8;
+    if (m.is_en_passant()) {
+      return en_passant && to == to_index(*en_passant) && (pawn_attacks(side, from) & square_bb(to))
+          && (target & (square_bb(to) | square_bb(to - up)));
+    }
+    const bool promotion = (us == White ? Rank8BB : Rank1BB) & square_bb(to);
+    const bool flag_matches = promotion ? m.is_promotion() && m.is_capture() == capture : m.flag() == plain_flag;
+    if (!flag_matches || !(target & square_bb(to))) {
+      return false;
+    }
+    if (capture) {
+      return pawn_attacks(side, from) & square_bb(to);
+    }
+    if (to == from + up) {
+      return !(occupied & square_bb(to));
+    }
+    return to == from + 2 * up && ((us == White ? Rank2BB : Rank7BB) & square_bb(from))
+        && !(occupied & (square_bb(from + up) | square_bb(to)));
+  }
+  if (m.flag() != plain_flag) {
+    return false;
+  }
+
+  Bitboard dests{};
+  switch (t) {
+    case Knight: dests = knight_attacks(from); break;
+    case Bishop: dests = bishop_attacks(from, occupied); break;
+    case Rook:   dests = rook_attacks(from, occupied); break;
+    case Queen:  dests = queen_attacks(from, occupied); break;
+    case King:   dests = king_attacks(from); break;
+    default:     assert(false);
+  }
+  return dests & target & square_bb(to);
+}
+
+template<MoveGenerator::GenType T, typename B>
+void MoveGenerator::generate(const B& board, MoveList& list, Color us, uint8_t castling_rights,
+                             std::optional<Square> en_passant, const CheckInfo& info) {
+  assert((T == GenType::Evasions) == bool(info.checkers));
+  const Bitboard ours = board.pieces(us);
+  const Bitboard enemies = board.pieces(us == White ? Black : White);
+  const Bitboard empty = ~board.occupancy();
+  const Bitboard promotion_rank = us == White ? Rank8BB : Rank1BB;
+
+  Bitboard target{};
+  Bitboard pawn_target{};
+  Bitboard king_target{};
+  switch (T) {
+    case GenType::Captures:
+      target = king_target = enemies;
+      pawn_target = enemies | (empty & promotion_rank);
+      break;
+    case GenType::Quiets:
+      target = king_target = empty;
+      pawn_target = empty & ~promotion_rank;
+      en_passant = std::nullopt;
+      break;
+    case GenType::Evasions:
+      target = pawn_target = between_bb(info.king_sqr, lsb(info.checkers)) | info.checkers;
+      king_target = ~ours;
+      break;
+    case GenType::NonEvasions:
+      target = pawn_target = king_target = ~ours;
+      break;
+  }
+
+  // Under double check only the king may move
+  if (T != GenType::Evasions || popcount(info.checkers) < 2) {
+    generate_pawn_moves(board, list, us, pawn_target, en_passant);
+    for (const auto t : {Knight, Bishop, Rook, Queen}) {
+      generate_piece_moves(board, list, us, t, target);
+    }
+  }
+  generate_piece_moves(board, list, us, King, king_target);
+  if (T == GenType::Quiets || T == GenType::NonEvasions) {
+    generate_castling_moves(board, list, us, castling_rights, info);
+  }
+}
+
+template<typename B>
+void MoveGenerator::generate_legal_moves(const B& board, MoveList& list, Color us, uint8_t castling_rights,
+                                         std::optional<Square> en_passant) {
+  list.clear();
+  const CheckInfo info = get_check_info(board, us);
+  if (info.checkers) {
+    generate<GenType::Evasions>(board, list, us, castling_rights, en_passant, info);
+  } else {
+    generate<GenType::NonEvasions>(board, list, us, castling_rights, en_passant, info);
+  }
+
+  size_t legal{};
+  for (const PackedMove m : list) {
+    if (is_legal(board, us, m, info)) {
+      list[legal++] = m;
+    }
+  }
+  list.resize(legal);
+}
+
+#define INSTANTIATE_GENERATE(T, B) \
+  template void MoveGenerator::generate<MoveGenerator::T, B>(const B&, MoveList&, Color, uint8_t, \
+                                                             std::optional<Square>, const CheckInfo&);
+
+#define INSTANTIATE_GENERATORS(B) \
+  template void MoveGenerator::generate_pawn_moves(const B&, MoveList&, Color, Bitboard, std::optional<Square>); \
+  template void MoveGenerator::generate_piece_moves(const B&, MoveList&, Color, PieceType, Bitboard); \
+  template void MoveGenerator::generate_castling_moves(const B&, MoveList&, Color, uint8_t, const CheckInfo&); \
+  template MoveGenerator::CheckInfo MoveGenerator::get_check_info(const B&, Color); \
+  template bool MoveGenerator::is_legal(const B&, Color, PackedMove, const CheckInfo&); \
+  template bool MoveGenerator::is_pseudo_legal(const B&, Color, PackedMove, uint8_t, std::optional<Square>, \
+                                               const CheckInfo&); \
+  template void MoveGenerator::generate_legal_moves(const B&, MoveList&, Color, uint8_t, std::optional<Square>); \
+  INSTANTIATE_GENERATE(GenType::Captures, B) \
+  INSTANTIATE_GENERATE(GenType::Quiets, B) \
+  INSTANTIATE_GENERATE(GenType::Evasions, B) \
+  INSTANTIATE_GENERATE(GenType::NonEvasions, B)
+
+INSTANTIATE_GENERATORS(GameBoard)
+INSTANTIATE_GENERATORS(PositionSnapshot)
+
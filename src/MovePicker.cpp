@@ -0,0 +1,177 @@
+#include <MovePicker.h>
+#include <See.h>
+
+namespace {
+  // Lifts tactical evasions above any history score
+  constexpr int tactical_bonus = 1 << 24;
+}
+
+MovePicker::MovePicker(const ChessGame& game, PackedMove hash_move, const std::array<PackedMove, 2>& killers,
+                       const HistoryTable* history)
+  : board(game.get_board()),
+    us(game.get_current_turn()),
+    castling_rights(game.castling_rights()),
+    en_passant(game.en_passant_square()),
+    info(MoveGenerator::get_check_info(board, us)),
+    hash_move(hash_move),
+    killers(killers),
+    history(history),
+    captures_only(false) {}
+
+MovePicker::MovePicker(const ChessGame& game, PackedMove hash_move)
+  : board(game.get_board()),
+    us(game.get_current_turn()),
+    castling_rights(game.castling_rights()),
+    en_passant(game.en_passant_square()),
+    info(MoveGenerator::get_check_info(board, us)),
+    hash_move(hash_move),
+    captures_only(true) {
+  if (!info.checkers && !hash_move.is_capture() && !hash_move.is_promotion()) {
+    this->hash_move = PackedMove{};
+  }
+}
+
+bool MovePicker::is_legal(PackedMove m) const {
+  return MoveGenerator::is_legal(board, us, m, info);
+}
+
+bool MovePicker::is_tried(PackedMove m) const {
+  return m == hash_move || m == killers[0] || m == killers[1];
+}
+
+int MovePicker::capture_score(PackedMove m) const {
+  // Most valuable victim first, least valuable attacker breaking ties
+  int score = 0;
+  if (m.is_capture()) {
+    const PieceType victim = m.is_en_passant() ? Pawn : board.at(to_square(m.to())).type;
+    score = piece_value[victim] * 8 - piece_value[board.at(to_square(m.from())).type] / 100;
+  }
+  return score + (m.is_promotion() ? piece_value[m.promotion_piece()] * 8 : 0);
+}
+
+template<MoveGenerator::GenType T>
+void MovePicker::generate() {
+  moves.clear();
+  current = 0;
+  MoveGenerator::generate<T>(board, moves, us, castling_rights, en_passant, info);
+  for (size_t i = 0; i < moves.size(); ++i) {
+    const PackedMove m = moves[i];
+    const int quiet_score = history ? (*history)[m.from()][m.to()] : 0;
+    if (T == MoveGenerator::GenType::Captures) {
+      scores[i] = capture_score(m);
+    } else if (T == MoveGenerator::GenType::Evasions && (m.is_capture() || m.is_promotion())) {
+      scores[i] = tactical_bonus + capture_score(m);
+    } else {
+      scores[i] = quiet_score;
+    }
+  }
+}
+
+PackedMove MovePicker::pick_best() {
+  size_t best = current;
+  for (size_t i = current + 1; i < moves.size(); ++i) {
+    if (scores[i] > scores[best]) {
+      best = i;
+    }
+  }
+  std::swap(moves[current], moves[best]);
+  std::swap(scores[current], scores[best]);
+  return moves[current++];
+}
+
+PackedMove MovePicker::next() {
+  switch (stage) {
+    case Stage::HashMove:
+      stage = info.checkers ? Stage::GenerateEvasions : Stage::GenerateCaptures;
+      if (hash_move && MoveGenerator::is_pseudo_legal(board, us, hash_move, castling_rights, en_passant, info)
+          && is_legal(hash_move)) {
+        return hash_move;
+      }
+      hash_move = PackedMove{};
+      return next();
+
+    case Stage::GenerateCaptures:
+      generate<MoveGenerator::GenType::Captures>();
+      stage = Stage::Captures;
+      [[fallthrough]];
+
+    case Stage::Captures:
+      while (current < moves.size()) {
+        const PackedMove m = pick_best();
+        if (m == hash_move) {
+          continue;
+        }
+        if (!see_ge(board, m, 0)) {
+          if (!captures_only) {
+            bad_captures.push_back(m);
+          }
+          continue;
+        }
+        if (is_legal(m)) {
+          return m;
+        }
+      }
+      if (captures_only) {
+        stage = Stage::Done;
+        return PackedMove{};
+      }
+      stage = Stage::Killers;
+      [[fallthrough]];
+
+    case Stage::Killers:
+      while (killer_index < killers.size()) {
+        const PackedMove k = killers[killer_index++];
+        if (k && k != hash_move && (killer_index == 1 || k != killers[0]) && !k.is_capture() && !k.is_promotion()
+            && MoveGenerator::is_pseudo_legal(board, us, k, castling_rights, en_passant, info) && is_legal(k)) {
+          return k;
+        }
+      }
+      stage = Stage::GenerateQuiets;
+      [[fallthrough]];
+
+    case Stage::GenerateQuiets:
+      generate<MoveGenerator::GenType::Quiets>();
+      stage = Stage::Quiets;
+      [[fallthrough]];
+
+    case Stage::Quiets:
+      while (current < moves.size()) {
+        const PackedMove m = pick_best();
+        if (!is_tried(m) && is_legal(m)) {
+          return m;
+        }
+      }
+      stage = Stage::BadCaptures;
+      current = 0;
+      [[fallthrough]];
+
+    case Stage::BadCaptures:
+      while (current < bad_captures.size()) {
+        const PackedMove m = bad_captures[current++];
+        if (is_legal(m)) {
+          return m;
+        }
+      }
+      stage = Stage::Done;
+      return PackedMove{};
+
+    case Stage::GenerateEvasions:
+      generate<MoveGenerator::GenType::Evasions>();
+      stage = Stage::Evasions;
+      [[fallthrough]];
+
+    case Stage::Evasions:
+      while (current < moves.size()) {
+        const PackedMove m = pick_best();
+        if (m != hash_move && is_legal(m)) {
+          return m;
+        }
+      }
+      stage = Stage::Done;
+      [[fallthrough]];
+
+    case Stage::Done:
+      return PackedMove{};
+  }
+  return PackedMove{};
+}
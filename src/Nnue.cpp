@@ -0,0 +1,207 @@
+#include <Nnue.h>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NNUE_X86 1
+#endif
+
+namespace {
+  using Nnue::hidden_size;
+  using Nnue::activation_max;
+
+  void add_scalar(int16_t* acc, const int16_t* w) {
+    for (size_t i = 0; i < hidden_size; ++i) {
+      acc[i] = static_cast<int16_t>(acc[i] + w[i]);
+    }
+  }
+
+  void sub_scalar(int16_t* acc, const int16_t* w) {
+    for (size_t i = 0; i < hidden_size; ++i) {
+      acc[i] = static_cast<int16_t>(acc[i] - w[i]);
+    }
+  }
+
+  int32_t dot_scalar(const int16_t* acc, const int16_t* w) {
+    int32_t sum = 0;
+    for (size_t i = 0; i < hidden_size; ++i) {
+      sum += std::clamp<int32_t>(acc[i], 0, activation_max) * w[i];
+    }
+    return sum;
+  }
+
+#ifdef NNUE_X86
+  __attribute__((target("sse2"))) void add_sse2(int16_t* acc, const int16_t* w) {
+    for (size_t i = 0; i < hidden_size; i += 8) {
+      auto* a = reinterpret_cast<__m128i*>(acc + i);
+      _mm_store_si128(a, _mm_add_epi16(_mm_load_si128(a), _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i))));
+    }
+  }
+
+  __attribute__((target("sse2"))) void sub_sse2(int16_t* acc, const int16_t* w) {
+    for (size_t i = 0; i < hidden_size; i += 8) {
+      auto* a = reinterpret_cast<__m128i*>(acc + i);
+      _mm_store_si128(a, _mm_sub_epi16(_mm_load_si128(a), _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i))));
+    }
+  }
+
+  __attribute__((target("sse2"))) int32_t dot_sse2(const int16_t* acc, const int16_t* w) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(activation_max);
+    __m128i sum = _mm_setzero_si128();
+    for (size_t i = 0; i < hidden_size; i += 8) {
+      const __m128i a = _mm_min_epi16(_mm_max_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(acc + i)), zero), max);
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(a, _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i))));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+  }
+
+  __attribute__((target("avx2"))) void add_avx2(int16_t* acc, const int16_t* w) {
+    for (size_t i = 0; i < hidden_size; i += 16) {
+      auto* a = reinterpret_cast<__m256i*>(acc + i);
+      _mm256_store_si256(a, _mm256_add_epi16(_mm256_load_si256(a), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i))));
+    }
+  }
+
+  __attribute__((target("avx2"))) void sub_avx2(int16_t* acc, const int16_t* w) {
+    for (size_t i = 0; i < hidden_size; i += 16) {
+      auto* a = reinterpret_cast<__m256i*>(acc + i);
+      _mm256_store_si256(a, _mm256_sub_epi16(_mm256_load_si256(a), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i))));
+    }
+  }
+
+  __attribute__((target("avx2"))) int32_t dot_avx2(const int16_t* acc, const int16_t* w) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi16(activation_max);
+    __m256i sum = _mm256_setzero_si256();
+    for (size_t i = 0; i < hidden_size; i += 16) {
+      const __m256i a = _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i)), zero), max);
+      sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i))));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    return _mm_cvtsi128_si32(half);
+  }
+#endif
+
+  struct Kernels {
+    void (*add)(int16_t*, const int16_t*);
+    void (*sub)(int16_t*, const int16_t*);
+    int32_t (*dot)(const int16_t*, const int16_t*);
+  };
+
+  Kernels kernels(Nnue::Simd s) {
+    switch (s) {
+#ifdef NNUE_X86
+      case Nnue::Simd::Avx2: return {add_avx2, sub_avx2, dot_avx2};
+      case Nnue::Simd::Sse2: return {add_sse2, sub_sse2, dot_sse2};
+#endif
+      default: return {add_scalar, sub_scalar, dot_scalar};
+    }
+  }
+
+  struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t features;
+    uint32_t hidden;
+  };
+  static_assert(sizeof(Header) == 16);
+}
+
+namespace Nnue {
+  Simd detect_simd() {
+#ifdef NNUE_X86
+    if (__builtin_cpu_supports("avx2")) {
+      return Simd::Avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+      return Simd::Sse2;
+    }
+#endif
+    return Simd::Scalar;
+  }
+
+  Network::Network(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot open network file " + path);
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != file_size()) {
+      close(fd);
+      throw std::runtime_error("Network file " + path + " has the wrong size");
+    }
+    mapping_size = file_size();
+    mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+      mapping = nullptr;
+      throw std::runtime_error("Cannot map network file " + path);
+    }
+    madvise(mapping, mapping_size, MADV_WILLNEED);
+
+    const auto* bytes = static_cast<const char*>(mapping);
+    Header header{};
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, "NNUE", 4) != 0 || header.version != file_version
+        || header.features != feature_count || header.hidden != hidden_size) {
+      munmap(mapping, mapping_size);
+      mapping = nullptr;
+      throw std::runtime_error("Network file " + path + " does not match version " + std::to_string(file_version));
+    }
+    feature_bias = reinterpret_cast<const int16_t*>(bytes + sizeof(Header));
+    feature_weights = feature_bias + hidden_size;
+    output_weights = feature_weights + feature_count * hidden_size;
+    std::memcpy(&output_bias, output_weights + 2 * hidden_size, sizeof(output_bias));
+    simd = detect_simd();
+  }
+
+  Network::~Network() {
+    if (mapping) {
+      munmap(mapping, mapping_size);
+    }
+  }
+
+  void Network::refresh(Accumulator& acc, Color perspective, const GameBoard& board) const {
+    const Kernels k = kernels(simd);
+    int16_t* values = acc.values[GameBoard::color_index(perspective)].data();
+    std::memcpy(values, feature_bias, hidden_size * sizeof(int16_t));
+    const int king = to_index(board.king_square(perspective));
+    Bitboard pieces = board.occupancy() & ~board.pieces(King);
+    while (pieces) {
+      const int sq = pop_lsb(pieces);
+      k.add(values, column(feature_index(perspective, king, board.at(to_square(sq)), sq)));
+    }
+  }
+
+  void Network::update(Accumulator& acc, Color perspective, std::span<const size_t> added,
+                       std::span<const size_t> removed) const {
+    const Kernels k = kernels(simd);
+    int16_t* values = acc.values[GameBoard::color_index(perspective)].data();
+    for (const size_t f : removed) {
+      k.sub(values, column(f));
+    }
+    for (const size_t f : added) {
+      k.add(values, column(f));
+    }
+  }
+
+  int Network::evaluate(const Accumulator& acc, Color side) const {
+    const Kernels k = kernels(simd);
+    const Color them = side == White ? Black : White;
+    const int64_t sum = static_cast<int64_t>(k.dot(acc.values[GameBoard::color_index(side)].data(), output_weights))
+                      + k.dot(acc.values[GameBoard::color_index(them)].data(), output_weights + hidden_size)
+                      + output_bias;
+    return static_cast<int>(sum * output_scale / (activation_max * weight_scale));
+  }
+}
@@ -0,0 +1,72 @@
+#include <ParallelSearch.h>
+#include <algorithm>
+
+ParallelSearch::ParallelSearch(TranspositionTable& tt, size_t threads) : tt(tt) {
+  set_threads(threads);
+}
+
+void ParallelSearch::set_threads(size_t threads) {
+  pool.reset();
+  if (threads > 1) {
+    pool = std::make_unique<ThreadPool>(threads - 1);
+  }
+}
+
+void ParallelSearch::stop() {
+  stop_requested.store(true, std::memory_order_relaxed);
+}
+
+SearchResult ParallelSearch::run(const ChessGame& game, const SearchLimits& limits,
+                                 const std::function<void(const SearchResult&)>& on_iteration) {
+  std::vector<std::unique_ptr<Search>> searches;
+  for (size_t i = 0; i < threads(); ++i) {
+    searches.push_back(std::make_unique<Search>(game, &tt, i));
+    searches.back()->set_tablebases(tablebases);
+  }
+
+  auto total_nodes = [&searches] {
+    uint64_t nodes = 0;
+    for (const auto& search : searches) {
+      nodes += search->nodes_searched();
+    }
+    return nodes;
+  };
+
+  // A caller's own flag stops the main search, which in turn stops the helpers
+  SearchLimits main_limits = limits;
+  if (!main_limits.stop) {
+    main_limits.stop = &stop_requested;
+  }
+  SearchLimits helper_limits;
+  helper_limits.depth = limits.depth;
+  helper_limits.stop = &stop_requested;
+
+  // Helpers may store a few entries before the main search bumps the table generation,
+  // those only age one search early
+  for (size_t i = 1; i < searches.size(); ++i) {
+    pool->submit([&searches, &helper_limits, i](size_t) { searches[i]->run(helper_limits); });
+  }
+
+  SearchResult result = searches[0]->run(main_limits, [&](const SearchResult& r) {
+    if (on_iteration) {
+      SearchResult report = r;
+      report.nodes = total_nodes();
+      on_iteration(report);
+    }
+  });
+  stop_requested.store(true, std::memory_order_relaxed);
+  if (pool) {
+    pool->wait();
+  }
+  // Only cleared once every helper is done, a stop() before or during this run is never lost
+  stop_requested.store(false, std::memory_order_relaxed);
+
+  result.nodes = total_nodes();
+  last_stats = {};
+  last_pawn_stats = {};
+  for (const auto& search : searches) {
+    last_stats += search->tt_stats();
+    last_pawn_stats += search->pawn_stats();
+  }
+  return result;
+}
@@ -0,0 +1,93 @@
+#include <PawnTable.h>
+#include <algorithm>
+#include <bit>
+
+namespace {
+  constexpr Bitboard north(Bitboard b) { return b << 8; }
+  constexpr Bitboard south(Bitboard b) { return b >> 8; }
+  constexpr Bitboard east(Bitboard b) { return (b << 1) & ~FileABB; }
+  constexpr Bitboard west(Bitboard b) { return (b >> 1) & ~FileHBB; }
+
+  constexpr Bitboard north_fill(Bitboard b) {
+    b |= b << 8;
+    b |= b << 16;
+    return b | b << 32;
+  }
+
+  constexpr Bitboard south_fill(Bitboard b) {
+    b |= b >> 8;
+    b |= b >> 16;
+    return b | b >> 32;
+  }
+
+  constexpr Eval::Score doubled{-10, -20};
+  constexpr Eval::Score isolated{-10, -15};
+  constexpr Eval::Score backward{-8, -10};
+  // By rank counted from the side's own back rank
+  constexpr std::array<Eval::Score, 8> passed_bonus = {{{0, 0}, {5, 10}, {10, 20}, {15, 35}, {25, 60}, {40, 100}, {60, 150}, {0, 0}}};
+
+  void add(Eval::Score& s, Eval::Score term, int count) {
+    s.mg += term.mg * count;
+    s.eg += term.eg * count;
+  }
+
+  // Terms for the side owning ours as if it moved north. Black is evaluated on
+  // vertically mirrored bitboards and its sets mirrored back.
+  Eval::Score side_terms(Bitboard ours, Bitboard theirs, Bitboard& passed, Bitboard& attack_span) {
+    const Bitboard our_attacks = east(north(ours)) | west(north(ours));
+    const Bitboard their_attacks = east(south(theirs)) | west(south(theirs));
+    const Bitboard their_front = south_fill(south(theirs));
+    const Bitboard behind_own = south_fill(south(ours));
+    const Bitboard files = north_fill(ours) | south_fill(ours);
+
+    attack_span = north_fill(our_attacks);
+    passed = ours & ~(their_front | east(their_front) | west(their_front)) & ~behind_own;
+    const Bitboard lone = ours & ~(east(files) | west(files));
+    // Stop square attacked by an enemy pawn and no friendly pawn beside or behind to cover the advance
+    const Bitboard lagging = ours & ~lone & south(their_attacks) & ~north_fill(east(ours) | west(ours));
+
+    Eval::Score s;
+    add(s, doubled, popcount(ours & behind_own));
+    add(s, isolated, popcount(lone));
+    add(s, backward, popcount(lagging));
+    for (Bitboard b = passed; b;) {
+      s += passed_bonus[pop_lsb(b) >> 3];
+    }
+    return s;
+  }
+}
+
+PawnTableStats& PawnTableStats::operator+=(const PawnTableStats& other) {
+  probes += other.probes;
+  hits += other.hits;
+  return *this;
+}
+
+PawnEntry evaluate_pawns(Bitboard white_pawns, Bitboard black_pawns) {
+  PawnEntry e;
+  e.score = side_terms(white_pawns, black_pawns, e.passed[0], e.attack_span[0]);
+  e.score -= side_terms(std::byteswap(black_pawns), std::byteswap(white_pawns), e.passed[1], e.attack_span[1]);
+  e.passed[1] = std::byteswap(e.passed[1]);
+  e.attack_span[1] = std::byteswap(e.attack_span[1]);
+  return e;
+}
+
+PawnTable::PawnTable(size_t entries)
+: table(std::bit_floor(std::max<size_t>(entries, 1))) {}
+
+const PawnEntry& PawnTable::probe(uint64_t key, Bitboard white_pawns, Bitboard black_pawns) {
+  counters.probes++;
+  PawnEntry& entry = table[key & (table.size() - 1)];
+  if (entry.key == key) {
+    counters.hits++;
+    return entry;
+  }
+  entry = evaluate_pawns(white_pawns, black_pawns);
+  entry.key = key;
+  return entry;
+}
+
+void PawnTable::clear() {
+  std::fill(table.begin(), table.end(), PawnEntry{});
+  counters = {};
+}
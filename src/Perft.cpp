@@ -0,0 +1,161 @@
+#include <Perft.h>
+#include <ThreadPool.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <optional>
+
+namespace {
+  constexpr uint64_t node_mask = (1ULL << 56) - 1;
+  constexpr int max_split_ply = 8;
+
+  struct Subtree {
+    size_t root;
+    std::array<PackedMove, max_split_ply> path;
+    int length;
+  };
+
+  void collect_subtrees(ChessGame& game, int split_ply, Subtree& current, std::vector<Subtree>& out) {
+    if (current.length == split_ply) {
+      out.push_back(current);
+      return;
+    }
+    MoveList moves;
+    game.generate_legal_moves(moves);
+    for (size_t i = 0; i < moves.size(); ++i) {
+      if (current.length == 0) {
+        current.root = i;
+      }
+      current.path[current.length++] = moves[i];
+      game.apply_move(moves[i]);
+      collect_subtrees(game, split_ply, current, out);
+      game.undo_move();
+      current.length--;
+    }
+  }
+}
+
+PerftCache::PerftCache(size_t size_mb) {
+  const size_t count = std::max<size_t>(1, size_mb * 1024 * 1024 / sizeof(Entry));
+  entries.resize(std::bit_floor(count));
+  mask = entries.size() - 1;
+}
+
+bool PerftCache::probe(uint64_t key, int depth, uint64_t& nodes) const {
+  const Entry& e = entries[key & mask];
+  if (e.key != key || static_cast<int>(e.data >> 56) != depth) {
+    return false;
+  }
+  nodes = e.data & node_mask;
+  return true;
+}
+
+void PerftCache::store(uint64_t key, int depth, uint64_t nodes) {
+  Entry& e = entries[key & mask];
+  if (e.key != 0 && static_cast<int>(e.data >> 56) > depth) {
+    return;
+  }
+  e.key = key;
+  e.data = (static_cast<uint64_t>(depth) << 56) | (nodes & node_mask);
+}
+
+void PerftCache::clear() {
+  std::fill(entries.begin(), entries.end(), Entry{});
+}
+
+uint64_t perft(ChessGame& game, int depth, PerftCache* cache) {
+  if (depth == 0) {
+    return 1;
+  }
+  MoveList moves;
+  game.generate_legal_moves(moves);
+  // Counting the moves is cheaper than a cache probe one ply from the leaves
+  if (depth == 1) {
+    return moves.size();
+  }
+  uint64_t nodes{};
+  if (cache && cache->probe(game.key(), depth, nodes)) {
+    return nodes;
+  }
+  for (const auto m : moves) {
+    game.apply_move(m);
+    nodes += perft(game, depth - 1, cache);
+    game.undo_move();
+  }
+  if (cache) {
+    cache->store(game.key(), depth, nodes);
+  }
+  return nodes;
+}
+
+std::vector<RootMoveCount> perft_divide(ChessGame& game, int depth, PerftCache* cache) {
+  std::vector<RootMoveCount> counts;
+  MoveList moves;
+  game.generate_legal_moves(moves);
+  for (const auto m : moves) {
+    game.apply_move(m);
+    counts.push_back({m, perft(game, depth - 1, cache)});
+    game.undo_move();
+  }
+  return counts;
+}
+
+std::vector<RootMoveCount> parallel_perft_divide(const ChessGame& game, int depth, size_t threads,
+                                                 int split_ply, size_t cache_mb) {
+  if (depth < 1) {
+    return {};
+  }
+  split_ply = std::clamp(split_ply, 1, std::min(depth, max_split_ply));
+
+  ChessGame root(game);
+  MoveList root_moves;
+  root.generate_legal_moves(root_moves);
+  std::vector<Subtree> subtrees;
+  Subtree current{};
+  collect_subtrees(root, split_ply, current, subtrees);
+
+  ThreadPool pool(threads);
+  std::vector<ChessGame> games(pool.size(), root);
+  std::vector<std::optional<PerftCache>> caches(pool.size());
+  if (cache_mb) {
+    for (auto& c : caches) {
+      c.emplace(cache_mb);
+    }
+  }
+  auto totals = std::make_unique<std::atomic<uint64_t>[]>(root_moves.size());
+
+  for (const Subtree& subtree : subtrees) {
+    pool.submit([&, subtree, depth] (size_t worker) {
+      ChessGame& g = games[worker];
+      for (int i = 0; i < subtree.length; ++i) {
+        g.apply_move(subtree.path[i]);
+      }
+      const uint64_t nodes = perft(g, depth - subtree.length, caches[worker] ? &*caches[worker] : nullptr);
+      for (int i = 0; i < subtree.length; ++i) {
+        g.undo_move();
+      }
+      totals[subtree.root].fetch_add(nodes, std::memory_order_relaxed);
+    });
+  }
+  pool.wait();
+
+  std::vector<RootMoveCount> counts;
+  counts.reserve(root_moves.size());
+  for (size_t i = 0; i < root_moves.size(); ++i) {
+    counts.push_back({root_moves[i], totals[i].load()});
+  }
+  return counts;
+}
+
+uint64_t parallel_perft(const ChessGame& game, int depth, size_t threads, int split_ply, size_t cache_mb) {
+  if (depth == 0) {
+    return 1;
+  }
+  uint64_t nodes{};
+  for (const auto& [move, count] : parallel_perft_divide(game, depth, threads, split_ply, cache_mb)) {
+    nodes += count;
+  }
+  return nodes;
+}
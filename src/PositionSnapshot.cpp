@@ -0,0 +1,153 @@
+#include <PositionSnapshot.h>
+#include <MoveGenerator.h>
+#include <See.h>
+#include <Zobrist.h>
+
+namespace {
+  /**
+   * Castling rights lost when a piece moves from or to each square: moving a king or
+   * rook off its home square, or capturing a rook there, gives up the matching right.
+   */
+  constexpr std::array<uint8_t, 64> castling_loss = [] {
+    std::array<uint8_t, 64> loss{};
+    loss[to_index({Rank_1, File_E})] = WhiteKingSide | WhiteQueenSide;
+    loss[to_index({Rank_1, File_H})] = WhiteKingSide;
+    loss[to_index({Rank_1, File_A})] = WhiteQueenSide;
+    loss[to_index({Rank_8, File_E})] = BlackKingSide | BlackQueenSide;
+    loss[to_index({Rank_8, File_H})] = BlackKingSide;
+    loss[to_index({Rank_8, File_A})] = BlackQueenSide;
+    return loss;
+  }();
+
+  uint64_t castling_and_en_passant_key(uint8_t castling, int en_passant) {
+    uint64_t key = Zobrist::keys.castling[castling];
+    if (en_passant >= 0) {
+      key ^= Zobrist::keys.en_passant_file[en_passant & 7];
+    }
+    return key;
+  }
+}
+
+PositionSnapshot::PositionSnapshot(const GameBoard& game_board, Color side_to_move, uint8_t castling_rights,
+                                   std::optional<Square> en_passant, uint16_t half_move_clock,
+                                   uint16_t full_moves, uint64_t key)
+: side(side_to_move)
+, castling(castling_rights)
+, en_passant_sqr(en_passant ? static_cast<int8_t>(to_index(*en_passant)) : int8_t{-1})
+, half_moves(half_move_clock)
+, full_move_count(full_moves)
+{
+  Bitboard occupied = game_board.occupancy();
+  while (occupied) {
+    const int sq = pop_lsb(occupied);
+    put_piece(game_board.at(to_square(sq)), sq);
+  }
+  hash = key;
+}
+
+PositionSnapshot::PositionSnapshot(std::span<const std::pair<Piece, int>> pieces, Color side_to_move)
+: side(side_to_move)
+{
+  for (const auto& [p, sq] : pieces) {
+    put_piece(p, sq);
+  }
+  hash ^= castling_and_en_passant_key(castling, en_passant_sqr);
+  if (side == Black) {
+    hash ^= Zobrist::keys.black_to_move;
+  }
+}
+
+Bitboard PositionSnapshot::attackers_to(int sq, Bitboard occupied) const {
+  return (pawn_attacks(1, sq) & pieces(White, Pawn))
+       | (pawn_attacks(0, sq) & pieces(Black, Pawn))
+       | (knight_attacks(sq) & pieces(Knight))
+       | (king_attacks(sq) & pieces(King))
+       | (bishop_attacks(sq, occupied) & (pieces(Bishop) | pieces(Queen)))
+       | (rook_attacks(sq, occupied) & (pieces(Rook) | pieces(Queen)));
+}
+
+std::optional<Square> PositionSnapshot::en_passant() const {
+  if (en_passant_sqr < 0) {
+    return std::nullopt;
+  }
+  return to_square(en_passant_sqr);
+}
+
+bool PositionSnapshot::in_check() const {
+  const Color them = side == White ? Black : White;
+  return attackers_to(lsb(pieces(side, King)), occupancy()) & pieces(them);
+}
+
+int PositionSnapshot::see(PackedMove m) const {
+  return ::see(*this, m);
+}
+
+bool PositionSnapshot::see_ge(PackedMove m, int threshold) const {
+  return ::see_ge(*this, m, threshold);
+}
+
+void PositionSnapshot::put_piece(Piece p, int sq) {
+  piece_bb[GameBoard::piece_index(p)] |= square_bb(sq);
+  color_bb[GameBoard::color_index(p.color)] |= square_bb(sq);
+  board[sq] = piece(p.color, p.type);
+  hash ^= Zobrist::keys.piece_square[GameBoard::piece_index(p)][sq];
+  psq += Eval::psqt[GameBoard::piece_index(p)][sq];
+  if (p.type == Pawn) {
+    pawn_hash ^= Zobrist::keys.piece_square[GameBoard::piece_index(p)][sq];
+  }
+  phase += Eval::phase_weight[p.type];
+}
+
+void PositionSnapshot::remove_piece(int sq) {
+  const Piece p = at(sq);
+  piece_bb[GameBoard::piece_index(p)] &= ~square_bb(sq);
+  color_bb[GameBoard::color_index(p.color)] &= ~square_bb(sq);
+  board[sq] = 0;
+  hash ^= Zobrist::keys.piece_square[GameBoard::piece_index(p)][sq];
+  psq -= Eval::psqt[GameBoard::piece_index(p)][sq];
+  if (p.type == Pawn) {
+    pawn_hash ^= Zobrist::keys.piece_square[GameBoard::piece_index(p)][sq];
+  }
+  phase -= Eval::phase_weight[p.type];
+}
+
+PositionSnapshot PositionSnapshot::make_move(PackedMove m) const {
+  PositionSnapshot next = *this;
+  const int from = m.from();
+  const int to = m.to();
+  const Piece p = at(from);
+  const bool capture = m.is_en_passant() || at(to).type != NoPiece;
+
+  next.hash ^= castling_and_en_passant_key(castling, en_passant_sqr);
+  next.en_passant_sqr = -1;
+
+  if (m.is_en_passant()) {
+    next.remove_piece((from & ~7) | (to & 7));
+  } else if (at(to).type != NoPiece) {
+    next.remove_piece(to);
+  }
+  next.remove_piece(from);
+  next.put_piece(m.is_promotion() ? Piece{m.promotion_piece(), p.color} : p, to);
+
+  if (m.is_castling()) {
+    const int rook_from = m.flag() == MoveFlag::KingCastle ? from + 3 : from - 4;
+    const int rook_to = m.flag() == MoveFlag::KingCastle ? from + 1 : from - 1;
+    next.remove_piece(rook_from);
+    next.put_piece(Piece{Rook, p.color}, rook_to);
+  }
+  if (p.type == Pawn && (to - from == 16 || from - to == 16)) {
+    next.en_passant_sqr = static_cast<int8_t>((from + to) / 2);
+  }
+  next.castling &= ~(castling_loss[from] | castling_loss[to]);
+  next.half_moves = p.type == Pawn || capture ? 0 : half_moves + 1;
+  if (side == Black) {
+    next.full_move_count++;
+  }
+  next.side = side == White ? Black : White;
+  next.hash ^= castling_and_en_passant_key(next.castling, next.en_passant_sqr) ^ Zobrist::keys.black_to_move;
+  return next;
+}
+
+void PositionSnapshot::generate_legal_moves(MoveList& list) const {
+  MoveGenerator::generate_legal_moves(*this, list, side, castling, en_passant());
+}
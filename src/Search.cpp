@@ -0,0 +1,276 @@
+#include <MovePicker.h>
+#include <Search.h>
+#include <algorithm>
+
+namespace {
+  constexpr int max_history = 1 << 20;
+  constexpr uint64_t time_check_interval = 1024;
+
+  // Lazy SMP helper i skips the iterations where ((depth + skip_phase[i]) / skip_size[i]) is
+  // odd, so helpers run ahead of the main search at different depths
+  constexpr std::array<int, 20> skip_size = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+  constexpr std::array<int, 20> skip_phase = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+  // Mate scores are stored relative to the node so they stay valid at any ply
+  int score_to_tt(int score, int ply) {
+    return score >= Search::mate_bound ? score + ply : score <= -Search::mate_bound ? score - ply : score;
+  }
+
+  int score_from_tt(int score, int ply) {
+    return score >= Search::mate_bound ? score - ply : score <= -Search::mate_bound ? score + ply : score;
+  }
+}
+
+Search::Search(const ChessGame& game, TranspositionTable* tt, size_t thread_index)
+  : game(game), tt(tt), thread_index(thread_index) {}
+
+void Search::stop() {
+  stop_requested.store(true, std::memory_order_relaxed);
+}
+
+bool Search::should_stop() {
+  if (aborted) {
+    return true;
+  }
+  if (stop_requested.load(std::memory_order_relaxed) || (limits.stop && limits.stop->load(std::memory_order_relaxed)) ||
+      (limits.nodes && nodes >= limits.nodes)) {
+    aborted = true;
+  } else if (nodes % time_check_interval == 0) {
+    published_nodes.store(nodes, std::memory_order_relaxed);
+    aborted = limits.move_time.count() && std::chrono::steady_clock::now() - start >= limits.move_time;
+  }
+  return aborted;
+}
+
+int Search::evaluate() {
+  const int score = game.evaluate(&pawns);
+  if (const auto pawn_side_wins = game.probe_kpk()) {
+    if (!*pawn_side_wins) {
+      return 0;
+    }
+    // The evaluation stays in the score so the pawn keeps advancing
+    return game.get_board().pieces(game.get_current_turn(), Pawn) ? known_win + score : score - known_win;
+  }
+  return score;
+}
+
+void Search::update_quiet_stats(int ply, int depth, PackedMove move) {
+  if (killers[ply][0] != move) {
+    killers[ply][1] = killers[ply][0];
+    killers[ply][0] = move;
+  }
+  int& h = history[move.from()][move.to()];
+  h = std::min(h + depth * depth, max_history);
+}
+
+void Search::update_pv(int ply, PackedMove move) {
+  pv[ply][0] = move;
+  const int child = ply + 1 < max_ply ? pv_length[ply + 1] : 0;
+  for (int i = 0; i < child; ++i) {
+    pv[ply][i + 1] = pv[ply + 1][i];
+  }
+  pv_length[ply] = child + 1;
+}
+
+int Search::quiescence(int ply, int alpha, int beta) {
+  pv_length[ply] = 0;
+  nodes++;
+  if (should_stop()) {
+    return 0;
+  }
+  if (ply >= max_ply - 1) {
+    return evaluate();
+  }
+
+  // In check every evasion is searched and standing pat is not an option
+  const bool in_check = game.in_check();
+  int best = -infinite_score;
+  if (!in_check) {
+    best = evaluate();
+    if (best >= beta) {
+      return best;
+    }
+    alpha = std::max(alpha, best);
+  }
+
+  MovePicker picker(game, PackedMove{});
+  int legal = 0;
+  while (const PackedMove move = picker.next()) {
+    legal++;
+    game.apply_move(move);
+    const int score = -quiescence(ply + 1, -beta, -alpha);
+    game.undo_move();
+    if (aborted) {
+      return 0;
+    }
+    if (score > best) {
+      best = score;
+      if (score > alpha) {
+        alpha = score;
+        update_pv(ply, move);
+        if (alpha >= beta) {
+          break;
+        }
+      }
+    }
+  }
+  if (in_check && !legal) {
+    return -mate_score + ply;
+  }
+  return best;
+}
+
+int Search::negamax(int depth, int ply, int alpha, int beta) {
+  pv_length[ply] = 0;
+  if (ply > 0 && game.is_draw()) {
+    return 0;
+  }
+  if (tablebases && ply > 0 && popcount(game.get_board().occupancy()) <= static_cast<int>(Tablebase::max_pieces)) {
+    if (const auto result = tablebases->probe(game.snapshot())) {
+      nodes++;
+      if (should_stop()) {
+        return 0;
+      }
+      const int mate = mate_score - ply - result->plies;
+      return result->wdl == Tablebase::Wdl::Win ? mate : result->wdl == Tablebase::Wdl::Loss ? -mate : 0;
+    }
+  }
+  const bool in_check = game.in_check();
+  // Extending checks keeps forcing lines from ending right before the reply
+  if (in_check) {
+    depth++;
+  }
+  if (depth <= 0 || ply >= max_ply - 1) {
+    return quiescence(ply, alpha, beta);
+  }
+  nodes++;
+  if (should_stop()) {
+    return 0;
+  }
+
+  const uint64_t key = game.key();
+  PackedMove hint = prev_pv[ply];
+  TTEntry entry;
+  if (tt && tt->probe(key, entry, &tt_counters)) {
+    // The move is only an ordering hint, so a key collision cannot make it play an illegal move
+    if (entry.move) {
+      hint = entry.move;
+    }
+    if (ply > 0 && entry.depth >= depth) {
+      const int score = score_from_tt(entry.score, ply);
+      if (entry.bound == Bound::Exact || (entry.bound == Bound::Lower && score >= beta) ||
+          (entry.bound == Bound::Upper && score <= alpha)) {
+        return score;
+      }
+    }
+  }
+
+  const int original_alpha = alpha;
+  int best = -infinite_score;
+  PackedMove best_move;
+  int legal = 0;
+  MovePicker picker(game, hint, killers[ply], &history);
+  while (const PackedMove move = picker.next()) {
+    legal++;
+    game.apply_move(move);
+    if (tt) {
+      tt->prefetch(game.key());
+    }
+    const int score = -negamax(depth - 1, ply + 1, -beta, -alpha);
+    game.undo_move();
+    if (aborted) {
+      return 0;
+    }
+    if (score > best) {
+      best = score;
+      if (score > alpha) {
+        alpha = score;
+        best_move = move;
+        update_pv(ply, move);
+        if (alpha >= beta) {
+          if (!move.is_capture() && !move.is_promotion()) {
+            update_quiet_stats(ply, depth, move);
+          }
+          break;
+        }
+      }
+    }
+  }
+  if (!legal) {
+    return in_check ? -mate_score + ply : 0;
+  }
+
+  if (tt) {
+    const Bound bound = best >= beta ? Bound::Lower : best > original_alpha ? Bound::Exact : Bound::Upper;
+    tt->store(key, best_move, score_to_tt(best, ply), depth, bound, &tt_counters);
+  }
+  return best;
+}
+
+SearchResult Search::run(const SearchLimits& search_limits,
+                         const std::function<void(const SearchResult&)>& on_iteration) {
+  limits = search_limits;
+  start = std::chrono::steady_clock::now();
+  aborted = false;
+  nodes = 0;
+  published_nodes.store(0, std::memory_order_relaxed);
+  prev_pv.fill(PackedMove{});
+  for (auto& k : killers) {
+    k.fill(PackedMove{});
+  }
+  for (auto& row : history) {
+    row.fill(0);
+  }
+  if (tt && thread_index == 0) {
+    tt->new_search();
+  }
+
+  SearchResult result;
+  MoveList root_moves;
+  game.generate_legal_moves(root_moves);
+  if (root_moves.empty()) {
+    result.score = game.in_check() ? -mate_score : 0;
+    stop_requested.store(false, std::memory_order_relaxed);
+    return result;
+  }
+  result.best_move = root_moves[0];
+
+  const int max_depth = std::clamp(limits.depth, 1, max_ply - 1);
+  for (int depth = 1; depth <= max_depth; ++depth) {
+    if (thread_index > 0 && depth < max_depth) {
+      const size_t i = (thread_index - 1) % skip_size.size();
+      if ((depth + skip_phase[i]) / skip_size[i] % 2) {
+        continue;
+      }
+    }
+    const int score = negamax(depth, 0, -infinite_score, infinite_score);
+    if (aborted) {
+      break;
+    }
+    result.score = score;
+    result.depth = depth;
+    result.pv.assign(pv[0].begin(), pv[0].begin() + pv_length[0]);
+    result.best_move = result.pv.empty() ? root_moves[0] : result.pv.front();
+    result.nodes = nodes;
+    result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::copy(result.pv.begin(), result.pv.end(), prev_pv.begin());
+    published_nodes.store(nodes, std::memory_order_relaxed);
+    if (on_iteration) {
+      on_iteration(result);
+    }
+    // A found mate cannot get shorter by searching deeper
+    if (is_mate_score(score) && mate_score - std::abs(score) <= depth) {
+      break;
+    }
+    // Another iteration costs several times the last one, do not start what cannot finish
+    if (limits.move_time.count() && result.elapsed * 2 >= limits.move_time) {
+      break;
+    }
+  }
+  result.nodes = nodes;
+  result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  published_nodes.store(nodes, std::memory_order_relaxed);
+  // Cleared on the way out rather than on entry, so a stop() that races with the start is kept
+  stop_requested.store(false, std::memory_order_relaxed);
+  return result;
+}
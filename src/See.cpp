@@ -0,0 +1,162 @@
+#include <See.h>
+#include <PositionSnapshot.h>
+#include <algorithm>
+#include <array>
+
+namespace {
+  constexpr Color other(Color c) {
+    return c == White ? Black : White;
+  }
+
+  template<typename B>
+  PieceType type_on(const B& board, int sq) {
+    for (const auto t : {Pawn, Knight, Bishop, Rook, Queen, King}) {
+      if (board.pieces(t) & square_bb(sq)) {
+        return t;
+      }
+    }
+    return NoPiece;
+  }
+
+  // Finds the least valuable piece among attackers, which must not be empty
+  template<typename B>
+  PieceType least_valuable(const B& board, Bitboard attackers, int& sq) {
+    for (const auto t : {Pawn, Knight, Bishop, Rook, Queen, King}) {
+      if (const Bitboard b = attackers & board.pieces(t)) {
+        sq = lsb(b);
+        return t;
+      }
+    }
+    return NoPiece;
+  }
+
+  // Adds the sliders that a capture by t from the now empty square uncovers
+  template<typename B>
+  Bitboard add_x_rays(const B& board, Bitboard attackers, int to, Bitboard occupied, PieceType t) {
+    if (t == Pawn || t == Bishop || t == Queen) {
+      attackers |= bishop_attacks(to, occupied) & (board.pieces(Bishop) | board.pieces(Queen));
+    }
+    if (t == Rook || t == Queen) {
+      attackers |= rook_attacks(to, occupied) & (board.pieces(Rook) | board.pieces(Queen));
+    }
+    return attackers & occupied;
+  }
+
+  // State right after m is played: material won so far and the piece left on the square
+  struct Exchange {
+    Color us;
+    int gain;
+    PieceType on_square;
+    Bitboard occupied;
+    Bitboard attackers;
+  };
+
+  template<typename B>
+  Exchange start_exchange(const B& board, PackedMove m) {
+    const int from = m.from();
+    const int to = m.to();
+    Exchange e{};
+    e.us = (board.pieces(White) & square_bb(from)) ? White : Black;
+    e.occupied = board.occupancy() ^ square_bb(from);
+    if (m.is_en_passant()) {
+      e.gain = piece_value[Pawn];
+      e.occupied ^= square_bb((from & ~7) | (to & 7));
+    } else {
+      e.gain = piece_value[type_on(board, to)];
+    }
+    e.on_square = type_on(board, from);
+    if (m.is_promotion()) {
+      e.gain += piece_value[m.promotion_piece()] - piece_value[Pawn];
+      e.on_square = m.promotion_piece();
+    }
+    e.attackers = board.attackers_to(to, e.occupied) & e.occupied;
+    return e;
+  }
+}
+
+template<typename B>
+int see(const B& board, PackedMove m) {
+  if (m.is_castling()) {
+    return 0;
+  }
+  Exchange e = start_exchange(board, m);
+  const int to = m.to();
+
+  // gain[d] is the balance for the side making capture d if the sequence stopped there
+  std::array<int, 32> gain{};
+  gain[0] = e.gain;
+  int d = 0;
+  Color side = e.us;
+  while (d + 1 < static_cast<int>(gain.size())) {
+    side = other(side);
+    const Bitboard ours = e.attackers & board.pieces(side);
+    if (!ours) {
+      break;
+    }
+    int sq{};
+    const PieceType t = least_valuable(board, ours, sq);
+    // The king may only recapture when nothing defends the square any more
+    if (t == King && (e.attackers & board.pieces(other(side)))) {
+      break;
+    }
+    d++;
+    gain[d] = piece_value[e.on_square] - gain[d - 1];
+    e.on_square = t;
+    e.occupied ^= square_bb(sq);
+    e.attackers = add_x_rays(board, e.attackers, to, e.occupied, t);
+  }
+  // Each side may decline to continue when recapturing would lose
+  for (; d > 0; --d) {
+    gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+  }
+  return gain[0];
+}
+
+template<typename B>
+bool see_ge(const B& board, PackedMove m, int threshold) {
+  if (m.is_castling()) {
+    return 0 >= threshold;
+  }
+  Exchange e = start_exchange(board, m);
+  const int to = m.to();
+
+  // Winning less than the threshold even unanswered fails, losing the piece and still
+  // reaching it succeeds
+  int swap = e.gain - threshold;
+  if (swap < 0) {
+    return false;
+  }
+  swap = piece_value[e.on_square] - swap;
+  if (swap <= 0) {
+    return true;
+  }
+
+  // res flips with each capture and holds the answer if the side to capture stops here
+  int res = 1;
+  Color side = e.us;
+  while (true) {
+    side = other(side);
+    const Bitboard ours = e.attackers & board.pieces(side);
+    if (!ours) {
+      break;
+    }
+    res ^= 1;
+    int sq{};
+    const PieceType t = least_valuable(board, ours, sq);
+    if (t == King) {
+      return (e.attackers & board.pieces(other(side))) ? res ^ 1 : res;
+    }
+    swap = piece_value[t] - swap;
+    if (swap < res) {
+      break;
+    }
+    e.occupied ^= square_bb(sq);
+    e.attackers = add_x_rays(board, e.attackers, to, e.occupied, t);
+  }
+  return res;
+}
+
+template int see(const GameBoard&, PackedMove);
+template int see(const PositionSnapshot&, PackedMove);
+template bool see_ge(const GameBoard&, PackedMove, int);
+template bool see_ge(const PositionSnapshot&, PackedMove, int);
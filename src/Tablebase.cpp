@@ -0,0 +1,782 @@
+#include <Tablebase.h>
+#include <ThreadPool.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  using Tablebase::max_pieces;
+  using Tablebase::max_plies;
+  using Squares = std::array<int, max_pieces>;
+  using Counts = std::array<std::array<int, 5>, 2>;
+
+  constexpr char magic[4] = {'C', 'E', 'T', 'B'};
+  constexpr uint8_t value_draw = 0;
+  // Only used while generating, positions still unresolved at the end are draws
+  constexpr uint8_t value_unresolved = 254;
+  constexpr uint8_t value_illegal = 255;
+  constexpr uint8_t exit_draw = 1;
+  constexpr uint8_t exit_win = 2;
+  constexpr size_t chunk_size = 1 << 14;
+
+  // Piece letters of a signature, strongest first
+  constexpr std::string_view letters = "QRBNP";
+  constexpr std::array<PieceType, 5> letter_types = {Queen, Rook, Bishop, Knight, Pawn};
+
+  struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    char signature[8];
+    uint64_t entries;
+  };
+  static_assert(sizeof(FileHeader) == 24);
+
+  // The a1-d1-d4 triangle that holds the white king of a pawnless table
+  constexpr std::array<int, 10> triangle = {0, 1, 2, 3, 9, 10, 11, 18, 19, 27};
+  constexpr std::array<int8_t, 64> triangle_slot = [] {
+    std::array<int8_t, 64> slots{};
+    slots.fill(-1);
+    for (size_t i = 0; i < triangle.size(); ++i) {
+      slots[triangle[i]] = static_cast<int8_t>(i);
+    }
+    return slots;
+  }();
+
+  // At most two of a piece fit in four pieces, so each count is a base 3 digit
+  constexpr size_t material_keys = 59049;
+
+  size_t material_key(const Counts& counts) {
+    size_t key = 0;
+    for (const auto& side : counts) {
+      for (const int n : side) {
+        key = key * 3 + static_cast<size_t>(n);
+      }
+    }
+    return key;
+  }
+
+  Color opposite(Color c) {
+    return c == White ? Black : White;
+  }
+
+  bool same_piece(Piece a, Piece b) {
+    return a.type == b.type && a.color == b.color;
+  }
+
+  // Orders the pieces of two sides so the canonical signature puts the stronger side first
+  bool at_least_as_strong(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+      return a.size() > b.size();
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+      if (a[i] != b[i]) {
+        return letters.find(a[i]) < letters.find(b[i]);
+      }
+    }
+    return true;
+  }
+
+  std::string side_letters(const std::array<int, 5>& counts) {
+    std::string s;
+    for (size_t i = 0; i < letters.size(); ++i) {
+      s.append(static_cast<size_t>(counts[i]), letters[i]);
+    }
+    return s;
+  }
+
+  std::string signature_of(const Counts& counts) {
+    std::string white = side_letters(counts[0]);
+    std::string black = side_letters(counts[1]);
+    if (!at_least_as_strong(white, black)) {
+      std::swap(white, black);
+    }
+    return "K" + white + "vK" + black;
+  }
+
+  Counts counts_of(const PositionSnapshot& position) {
+    Counts counts{};
+    for (size_t c = 0; c < 2; ++c) {
+      for (size_t i = 0; i < letter_types.size(); ++i) {
+        counts[c][i] = popcount(position.pieces(c ? Black : White, letter_types[i]));
+      }
+    }
+    return counts;
+  }
+
+  bool legal(const PositionSnapshot& position) {
+    const Color them = opposite(position.side_to_move());
+    return !(position.attackers_to(lsb(position.pieces(them, King)), position.occupancy())
+             & position.pieces(position.side_to_move()));
+  }
+
+  Bitboard attacks(PieceType type, int sq, Bitboard occupied) {
+    switch (type) {
+      case Knight: return knight_attacks(sq);
+      case Bishop: return bishop_attacks(sq, occupied);
+      case Rook: return rook_attacks(sq, occupied);
+      case Queen: return queen_attacks(sq, occupied);
+      case King: return king_attacks(sq);
+      default: return 0;
+    }
+  }
+
+  /**
+   * Piece order and index scheme of one signature. Pieces are the white king, the black
+   * king, then white's and black's other pieces in signature order. The index is a
+   * mixed radix number with one digit per piece.
+   */
+  struct Layout {
+    std::string name;
+    Counts counts{};
+    int count{};
+    std::array<Piece, max_pieces> pieces{};
+    std::array<size_t, max_pieces> slots{};
+    bool pawns{};
+    size_t entries{1};
+
+    static std::optional<Layout> parse(std::string_view signature) {
+      const size_t split = signature.find("vK");
+      if (signature.size() < 4 || signature.front() != 'K' || split == std::string_view::npos) {
+        return std::nullopt;
+      }
+      const std::string_view white = signature.substr(1, split - 1);
+      const std::string_view black = signature.substr(split + 2);
+      Layout layout;
+      layout.name = signature;
+      layout.pieces[0] = {King, White};
+      layout.pieces[1] = {King, Black};
+      layout.count = 2;
+      for (const auto& [side, color] : {std::pair{white, White}, std::pair{black, Black}}) {
+        for (const char c : side) {
+          const size_t letter = letters.find(c);
+          if (letter == std::string_view::npos || layout.count == static_cast<int>(max_pieces)) {
+            return std::nullopt;
+          }
+          layout.counts[color == White ? 0 : 1][letter]++;
+          layout.pieces[static_cast<size_t>(layout.count++)] = {letter_types[letter], color};
+          layout.pawns |= c == 'P';
+        }
+      }
+      if (layout.count < 3 || signature_of(layout.counts) != signature) {
+        return std::nullopt;
+      }
+      for (int i = 0; i < layout.count; ++i) {
+        const size_t n = i == 0 ? (layout.pawns ? 32 : 10) : layout.pieces[i].type == Pawn ? 48 : 64;
+        layout.slots[i] = n;
+        layout.entries *= n;
+      }
+      return layout;
+    }
+
+    size_t slot(int i, int sq) const {
+      if (i == 0) {
+        return pawns ? static_cast<size_t>((sq >> 3) * 4 + (sq & 7)) : static_cast<size_t>(triangle_slot[sq]);
+      }
+      return static_cast<size_t>(pieces[i].type == Pawn ? sq - 8 : sq);
+    }
+
+    int square(int i, size_t slot) const {
+      const int s = static_cast<int>(slot);
+      if (i == 0) {
+        return pawns ? (s / 4) * 8 + s % 4 : triangle[slot];
+      }
+      return pieces[i].type == Pawn ? s + 8 : s;
+    }
+
+    /**
+     * @return Index of the position, after moving the white king into its symmetry
+     * region and ordering identical pieces by square. Every position and its mirror
+     * images share one index, which retrograde analysis relies on.
+     */
+    size_t index(Squares sq) const {
+      const auto transform = [&](auto f) {
+        for (int i = 0; i < count; ++i) {
+          sq[i] = f(sq[i]);
+        }
+      };
+      const auto transpose = [](int s) { return (s & 7) << 3 | s >> 3; };
+      if ((sq[0] & 7) > File_D) {
+        transform([](int s) { return s ^ 7; });
+      }
+      if (pawns) {
+        return raw_index(sq);
+      }
+      if ((sq[0] >> 3) > Rank_4) {
+        transform([](int s) { return s ^ 56; });
+      }
+      if ((sq[0] >> 3) > (sq[0] & 7)) {
+        transform(transpose);
+      }
+      // On the diagonal the king stays put under transposition, the smaller index picks the orientation
+      if ((sq[0] >> 3) != (sq[0] & 7)) {
+        return raw_index(sq);
+      }
+      const size_t idx = raw_index(sq);
+      transform(transpose);
+      return std::min(idx, raw_index(sq));
+    }
+
+    size_t raw_index(Squares sq) const {
+      for (int i = 3; i < count; ++i) {
+        if (same_piece(pieces[i], pieces[i - 1]) && sq[i] < sq[i - 1]) {
+          std::swap(sq[i], sq[i - 1]);
+        }
+      }
+      size_t idx = 0;
+      for (int i = 0; i < count; ++i) {
+        idx = idx * slots[i] + slot(i, sq[i]);
+      }
+      return idx;
+    }
+
+    /**
+     * @return false when idx does not stand for a position: pieces share a square, or it
+     * is the mirror image of another index
+     */
+    bool decode(size_t idx, Squares& sq) const {
+      const size_t original = idx;
+      for (int i = count - 1; i >= 0; --i) {
+        sq[i] = square(i, idx % slots[i]);
+        idx /= slots[i];
+      }
+      for (int i = 0; i < count; ++i) {
+        for (int j = 0; j < i; ++j) {
+          if (sq[i] == sq[j]) {
+            return false;
+          }
+        }
+      }
+      return index(sq) == original;
+    }
+
+    PositionSnapshot position(const Squares& sq, Color side) const {
+      std::array<std::pair<Piece, int>, max_pieces> list{};
+      for (int i = 0; i < count; ++i) {
+        list[i] = {pieces[i], sq[i]};
+      }
+      return PositionSnapshot(std::span(list.data(), static_cast<size_t>(count)), side);
+    }
+  };
+
+  std::optional<Tablebase::ProbeResult> decode_value(uint8_t value) {
+    if (value == value_illegal) {
+      return std::nullopt;
+    }
+    if (value == value_draw) {
+      return Tablebase::ProbeResult{Tablebase::Wdl::Draw, 0};
+    }
+    const int plies = value - 1;
+    return Tablebase::ProbeResult{plies % 2 ? Tablebase::Wdl::Win : Tablebase::Wdl::Loss, plies};
+  }
+
+  bool is_double_push(const PositionSnapshot& position, PackedMove m) {
+    return position.at(m.from()).type == Pawn && (m.to() - m.from() == 16 || m.from() - m.to() == 16);
+  }
+
+  // Whether a is a better result than b for the side to move
+  bool better(Tablebase::ProbeResult a, Tablebase::ProbeResult b) {
+    if (a.wdl != b.wdl) {
+      return a.wdl > b.wdl;
+    }
+    return a.wdl == Tablebase::Wdl::Win ? a.plies < b.plies : a.wdl == Tablebase::Wdl::Loss && a.plies > b.plies;
+  }
+
+  /**
+   * Tables hold no en passant rights, so the position after a double push that allows
+   * an en passant capture is not the table's entry for it. The capture leads to a
+   * smaller table and is probed there.
+   * @return Best result of capturing en passant for the side to move in position, or
+   * nullopt when no such capture is legal
+   * @throws std::runtime_error if the table the capture leads to is not loaded
+   */
+  std::optional<Tablebase::ProbeResult> en_passant_result(const PositionSnapshot& position,
+                                                          const Tablebase::Tablebases& tables) {
+    if (!position.en_passant()) {
+      return std::nullopt;
+    }
+    MoveList moves;
+    position.generate_legal_moves(moves);
+    std::optional<Tablebase::ProbeResult> best;
+    for (const PackedMove m : moves) {
+      if (!m.is_en_passant()) {
+        continue;
+      }
+      const PositionSnapshot next = position.make_move(m);
+      const auto reply = tables.probe(next);
+      if (!reply) {
+        throw std::runtime_error("En passant needs the " + signature_of(counts_of(next)) + " table");
+      }
+      Tablebase::ProbeResult result = *reply;
+      if (result.wdl != Tablebase::Wdl::Draw) {
+        result = {result.wdl == Tablebase::Wdl::Win ? Tablebase::Wdl::Loss : Tablebase::Wdl::Win, result.plies + 1};
+      }
+      if (!best || better(result, *best)) {
+        best = result;
+      }
+    }
+    return best;
+  }
+}
+
+namespace Tablebase {
+  struct Tablebases::Table {
+    Layout layout;
+    void* mapping{};
+    size_t mapping_size{};
+    std::array<const uint8_t*, 2> values{};
+
+    ~Table() {
+      if (mapping) {
+        munmap(mapping, mapping_size);
+      }
+    }
+  };
+
+  std::vector<std::string> all_signatures() {
+    std::vector<std::string> signatures;
+    for (const char a : letters) {
+      signatures.push_back(std::string("K") + a + "vK");
+    }
+    for (size_t i = 0; i < letters.size(); ++i) {
+      for (size_t j = i; j < letters.size(); ++j) {
+        signatures.push_back(std::string("K") + letters[i] + letters[j] + "vK");
+        signatures.push_back(std::string("K") + letters[i] + "vK" + letters[j]);
+      }
+    }
+    // Captures lead to fewer pieces and promotions to fewer pawns
+    std::ranges::stable_sort(signatures, {}, [](const std::string& s) {
+      return std::pair{s.size(), std::ranges::count(s, 'P')};
+    });
+    return signatures;
+  }
+
+  Tablebases::Tablebases() : by_material(material_keys, nullptr) {}
+
+  Tablebases::~Tablebases() = default;
+
+  void Tablebases::add(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot open tablebase " + path);
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+      close(fd);
+      throw std::runtime_error("Tablebase " + path + " is too small");
+    }
+    auto table = std::make_unique<Table>();
+    table->mapping_size = static_cast<size_t>(st.st_size);
+    table->mapping = mmap(nullptr, table->mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (table->mapping == MAP_FAILED) {
+      table->mapping = nullptr;
+      throw std::runtime_error("Cannot map tablebase " + path);
+    }
+    madvise(table->mapping, table->mapping_size, MADV_RANDOM);
+
+    FileHeader header{};
+    std::memcpy(&header, table->mapping, sizeof(header));
+    const std::string signature(header.signature, strnlen(header.signature, sizeof(header.signature)));
+    auto layout = Layout::parse(signature);
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != file_version || !layout) {
+      throw std::runtime_error("Tablebase " + path + " has an unknown format or signature");
+    }
+    if (header.entries != layout->entries || table->mapping_size != sizeof(header) + 2 * header.entries) {
+      throw std::runtime_error("Tablebase " + path + " has the wrong size for " + signature);
+    }
+    const auto* data = static_cast<const uint8_t*>(table->mapping) + sizeof(header);
+    table->values = {data, data + header.entries};
+    table->layout = std::move(*layout);
+
+    const Counts counts = table->layout.counts;
+    by_material[material_key(counts)] = table.get();
+    by_material[material_key({counts[1], counts[0]})] = table.get();
+    const auto same = std::ranges::find_if(tables, [&](const auto& t) { return t->layout.name == signature; });
+    if (same != tables.end()) {
+      *same = std::move(table);
+    } else {
+      tables.push_back(std::move(table));
+    }
+  }
+
+  size_t Tablebases::load_directory(const std::string& directory) {
+    std::vector<std::string> paths;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+      if (entry.is_regular_file() && entry.path().extension() == ".dtm") {
+        paths.push_back(entry.path().string());
+      }
+    }
+    std::ranges::sort(paths);
+    for (const std::string& path : paths) {
+      add(path);
+    }
+    return paths.size();
+  }
+
+  bool Tablebases::contains(const std::string& signature) const {
+    return std::ranges::any_of(tables, [&](const auto& t) { return t->layout.name == signature; });
+  }
+
+  std::optional<ProbeResult> Tablebases::probe(const PositionSnapshot& position) const {
+    if (position.castling_rights() || position.en_passant()) {
+      return std::nullopt;
+    }
+    const int count = popcount(position.occupancy());
+    if (count > static_cast<int>(max_pieces)) {
+      return std::nullopt;
+    }
+    if (count == 2) {
+      return ProbeResult{Wdl::Draw, 0};
+    }
+    const Counts counts = counts_of(position);
+    const Table* table = by_material[material_key(counts)];
+    if (!table) {
+      return std::nullopt;
+    }
+    // Play the position with colours swapped and the board upside down when black is the stronger side
+    const Layout& layout = table->layout;
+    const bool flipped = counts[0] != layout.counts[0];
+    Squares sq{};
+    for (int i = 0; i < layout.count; ++i) {
+      const Piece p = layout.pieces[i];
+      Bitboard b = position.pieces(flipped ? opposite(p.color) : p.color, p.type);
+      if (i > 0 && same_piece(p, layout.pieces[i - 1])) {
+        b &= b - 1;
+      }
+      sq[i] = lsb(b) ^ (flipped ? 56 : 0);
+    }
+    const Color side = flipped ? opposite(position.side_to_move()) : position.side_to_move();
+    return decode_value(table->values[side == White ? 0 : 1][layout.index(sq)]);
+  }
+
+  GenerationStats generate(const std::string& signature, const std::string& directory, Tablebases& tables,
+                           size_t threads) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto parsed = Layout::parse(signature);
+    if (!parsed) {
+      throw std::runtime_error("Unknown tablebase signature " + signature);
+    }
+    const Layout& layout = *parsed;
+    const size_t entries = layout.entries;
+    threads = std::max<size_t>(threads, 1);
+
+    std::array<std::vector<std::atomic<uint8_t>>, 2> values;
+    // Set once a position is queued by retrograde propagation, so it is queued only once
+    std::array<std::vector<std::atomic<uint8_t>>, 2> queued;
+    // Summary of the moves that leave the table, written before propagation starts
+    std::array<std::vector<uint8_t>, 2> exit_flags;
+    std::array<std::vector<uint8_t>, 2> exit_loss;
+    for (size_t stm = 0; stm < 2; ++stm) {
+      values[stm] = std::vector<std::atomic<uint8_t>>(entries);
+      queued[stm] = std::vector<std::atomic<uint8_t>>(entries);
+      exit_flags[stm].resize(entries);
+      exit_loss[stm].resize(entries);
+    }
+
+    // Positions to resolve by plies to mate, each entry is index << 1 | side to move
+    std::vector<std::vector<uint32_t>> buckets(max_plies + 1);
+    // Positions to check for a loss again once a ply is resolved, see lost_in
+    std::vector<std::vector<uint32_t>> rechecks(max_plies + 1);
+    std::vector<std::vector<std::vector<uint32_t>>> local(threads, std::vector<std::vector<uint32_t>>(max_plies + 1));
+    std::vector<std::vector<std::vector<uint32_t>>> local_rechecks(threads, std::vector<std::vector<uint32_t>>(max_plies + 1));
+    const auto push = [&](size_t worker, int plies, size_t stm, size_t idx, bool recheck = false) {
+      if (plies > max_plies) {
+        throw std::runtime_error(signature + " has a mate longer than the format holds");
+      }
+      (recheck ? local_rechecks : local)[worker][static_cast<size_t>(plies)].push_back(static_cast<uint32_t>(idx << 1 | stm));
+    };
+
+    ThreadPool pool(threads);
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    const auto parallel_for = [&](size_t count, const auto& body) {
+      for (size_t begin = 0; begin < count; begin += chunk_size) {
+        const size_t end = std::min(begin + chunk_size, count);
+        pool.submit([&, begin, end](size_t worker) {
+          try {
+            for (size_t i = begin; i < end; ++i) {
+              body(worker, i);
+            }
+          } catch (...) {
+            std::lock_guard lock(error_mutex);
+            if (!error) {
+              error = std::current_exception();
+            }
+          }
+        });
+      }
+      pool.wait();
+      if (error) {
+        std::rethrow_exception(error);
+      }
+      for (const auto& [shared, per_worker] : {std::pair{&buckets, &local}, std::pair{&rechecks, &local_rechecks}}) {
+        for (auto& worker_buckets : *per_worker) {
+          for (size_t plies = 0; plies < worker_buckets.size(); ++plies) {
+            (*shared)[plies].insert((*shared)[plies].end(), worker_buckets[plies].begin(), worker_buckets[plies].end());
+            worker_buckets[plies].clear();
+          }
+        }
+      }
+    };
+
+    // Mates and positions decided by captures and promotions into smaller tables
+    parallel_for(entries, [&](size_t worker, size_t idx) {
+      for (size_t stm = 0; stm < 2; ++stm) {
+        Squares sq{};
+        if (!layout.decode(idx, sq)) {
+          values[stm][idx].store(value_illegal, std::memory_order_relaxed);
+          continue;
+        }
+        const PositionSnapshot position = layout.position(sq, stm ? Black : White);
+        if (!legal(position)) {
+          values[stm][idx].store(value_illegal, std::memory_order_relaxed);
+          continue;
+        }
+        values[stm][idx].store(value_unresolved, std::memory_order_relaxed);
+        MoveList moves;
+        position.generate_legal_moves(moves);
+        if (moves.empty()) {
+          if (position.in_check()) {
+            push(worker, 0, stm, idx);
+          } else {
+            values[stm][idx].store(value_draw, std::memory_order_relaxed);
+          }
+          continue;
+        }
+        int win = 0;
+        int loss = 0;
+        bool draw = false;
+        bool in_table = false;
+        for (const PackedMove m : moves) {
+          if (!m.is_capture() && !m.is_promotion()) {
+            in_table = true;
+            // Losing a double push to en passant bounds its loss, which lost_in can rely on from that ply on
+            if (is_double_push(position, m)) {
+              const auto reply = en_passant_result(position.make_move(m), tables);
+              if (reply && reply->wdl == Wdl::Win) {
+                push(worker, reply->plies, stm, idx, true);
+              }
+            }
+            continue;
+          }
+          const PositionSnapshot next = position.make_move(m);
+          const auto result = tables.probe(next);
+          if (!result) {
+            throw std::runtime_error(signature + " needs the " + signature_of(counts_of(next)) + " table");
+          }
+          if (result->wdl == Wdl::Loss) {
+            win = win ? std::min(win, result->plies + 1) : result->plies + 1;
+          } else if (result->wdl == Wdl::Win) {
+            loss = std::max(loss, result->plies + 1);
+          } else {
+            draw = true;
+          }
+        }
+        exit_flags[stm][idx] = static_cast<uint8_t>((draw ? exit_draw : 0) | (win ? exit_win : 0));
+        exit_loss[stm][idx] = static_cast<uint8_t>(loss);
+        if (win) {
+          push(worker, win, stm, idx);
+        } else if (!in_table) {
+          if (draw) {
+            values[stm][idx].store(value_draw, std::memory_order_relaxed);
+          } else {
+            push(worker, loss, stm, idx);
+          }
+        }
+      }
+    });
+
+    // A position is lost once every move inside the table reaches a win for the opponent
+    // and no exit saves it, in one more ply than the longest of those wins. After a double
+    // push the opponent may also capture en passant and wins with the faster of the two;
+    // while the table's entry is unresolved at resolved_plies the capture's win only
+    // counts once it is no longer.
+    const auto lost_in = [&](const PositionSnapshot& position, const Squares& sq, size_t stm, size_t idx,
+                             int resolved_plies) {
+      MoveList moves;
+      position.generate_legal_moves(moves);
+      int longest = -1;
+      for (const PackedMove m : moves) {
+        if (m.is_capture() || m.is_promotion()) {
+          continue;
+        }
+        Squares next = sq;
+        *std::ranges::find(next.begin(), next.begin() + layout.count, m.from()) = m.to();
+        const uint8_t v = values[stm ^ 1][layout.index(next)].load();
+        int win = v == value_unresolved || v == value_draw || v == value_illegal || (v - 1) % 2 == 0 ? 0 : v - 1;
+        if (is_double_push(position, m)) {
+          const auto reply = en_passant_result(position.make_move(m), tables);
+          if (reply && reply->wdl == Wdl::Win && (v != value_unresolved || reply->plies <= resolved_plies)) {
+            win = win ? std::min(win, reply->plies) : reply->plies;
+          }
+        }
+        if (!win) {
+          return 0;
+        }
+        longest = std::max(longest, win);
+      }
+      return std::max(longest + 1, static_cast<int>(exit_loss[stm][idx]));
+    };
+
+    // Retrograde propagation one ply at a time, so every win is found at its shortest distance
+    for (int plies = 0; plies <= max_plies; ++plies) {
+      const std::vector<uint32_t> level = std::move(buckets[static_cast<size_t>(plies)]);
+      buckets[static_cast<size_t>(plies)] = {};
+      parallel_for(level.size(), [&](size_t worker, size_t i) {
+        const size_t stm = level[i] & 1;
+        const size_t idx = level[i] >> 1;
+        uint8_t expected = value_unresolved;
+        if (!values[stm][idx].compare_exchange_strong(expected, static_cast<uint8_t>(plies + 1))) {
+          return;
+        }
+        Squares sq{};
+        layout.decode(idx, sq);
+        const Color mover = stm ? White : Black;
+        const size_t mover_stm = stm ^ 1;
+        Bitboard occupied = 0;
+        for (int j = 0; j < layout.count; ++j) {
+          occupied |= square_bb(sq[j]);
+        }
+        for (int j = 0; j < layout.count; ++j) {
+          const Piece p = layout.pieces[j];
+          if (p.color != mover) {
+            continue;
+          }
+          // Squares the piece could have come from without capturing
+          Bitboard origins = 0;
+          if (p.type == Pawn) {
+            const int back = p.color == White ? -8 : 8;
+            const int from = sq[j] + back;
+            if (from >= 8 && from < 56 && !(occupied & square_bb(from))) {
+              origins |= square_bb(from);
+              const int double_rank = p.color == White ? Rank_4 : Rank_5;
+              if (sq[j] >> 3 == double_rank && !(occupied & square_bb(from + back))) {
+                origins |= square_bb(from + back);
+              }
+            }
+          } else {
+            origins = attacks(p.type, sq[j], occupied) & ~occupied;
+          }
+          while (origins) {
+            Squares before_sq = sq;
+            before_sq[j] = pop_lsb(origins);
+            const PositionSnapshot before = layout.position(before_sq, mover);
+            if (!legal(before)) {
+              continue;
+            }
+            const size_t before_idx = layout.index(before_sq);
+            if (values[mover_stm][before_idx].load() != value_unresolved) {
+              continue;
+            }
+            if (plies % 2 == 0) {
+              // A double push wins only if capturing en passant loses too, and then no sooner than the capture
+              int win = plies + 1;
+              if (p.type == Pawn && (before_sq[j] - sq[j] == 16 || sq[j] - before_sq[j] == 16)) {
+                const auto reply =
+                  en_passant_result(before.make_move(PackedMove(before_sq[j], sq[j], MoveFlag::Quiet)), tables);
+                if (reply && reply->wdl != Wdl::Loss) {
+                  continue;
+                }
+                if (reply) {
+                  win = std::max(win, reply->plies + 1);
+                }
+              }
+              // A later win is not marked queued, a shorter one may still be found first
+              if (win > plies + 1) {
+                push(worker, win, mover_stm, before_idx);
+              } else if (!queued[mover_stm][before_idx].exchange(1)) {
+                push(worker, win, mover_stm, before_idx);
+              }
+            } else if (!exit_flags[mover_stm][before_idx]) {
+              const int loss = lost_in(before, before_sq, mover_stm, before_idx, plies);
+              if (loss > 0 && !queued[mover_stm][before_idx].exchange(1)) {
+                push(worker, loss, mover_stm, before_idx);
+              }
+            }
+          }
+        }
+      });
+
+      // Positions whose double push loses to en passant in plies, now that nothing shorter is left to find
+      const std::vector<uint32_t> recheck = std::move(rechecks[static_cast<size_t>(plies)]);
+      rechecks[static_cast<size_t>(plies)] = {};
+      parallel_for(recheck.size(), [&](size_t worker, size_t i) {
+        const size_t stm = recheck[i] & 1;
+        const size_t idx = recheck[i] >> 1;
+        if (values[stm][idx].load() != value_unresolved || exit_flags[stm][idx]) {
+          return;
+        }
+        Squares sq{};
+        layout.decode(idx, sq);
+        const int loss = lost_in(layout.position(sq, stm ? Black : White), sq, stm, idx, plies);
+        if (loss > 0 && !queued[stm][idx].exchange(1)) {
+          push(worker, loss, stm, idx);
+        }
+      });
+    }
+
+    GenerationStats stats;
+    std::vector<uint8_t> bytes(2 * entries);
+    for (size_t stm = 0; stm < 2; ++stm) {
+      for (size_t idx = 0; idx < entries; ++idx) {
+        uint8_t v = values[stm][idx].load(std::memory_order_relaxed);
+        if (v == value_unresolved) {
+          v = value_draw;
+        }
+        bytes[stm * entries + idx] = v;
+        if (v == value_illegal) {
+          continue;
+        }
+        stats.positions++;
+        if (v == value_draw) {
+          stats.draws++;
+        } else if ((v - 1) % 2) {
+          stats.wins++;
+          stats.longest_mate = std::max(stats.longest_mate, v - 1);
+        } else {
+          stats.losses++;
+        }
+      }
+    }
+
+    std::filesystem::create_directories(directory);
+    const std::string path = (std::filesystem::path(directory) / (signature + ".dtm")).string();
+    FileHeader header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = file_version;
+    std::memcpy(header.signature, signature.data(), std::min(signature.size(), sizeof(header.signature)));
+    header.entries = entries;
+    // Other processes may have the old table mapped, so it is replaced by a rename and never truncated
+    const std::string temp_path = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+      std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+      out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+      out.close();
+      if (!out) {
+        std::filesystem::remove(temp_path);
+        throw std::runtime_error("Cannot write tablebase " + path);
+      }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+      std::filesystem::remove(temp_path);
+      throw std::runtime_error("Cannot write tablebase " + path + ": " + ec.message());
+    }
+    tables.add(path);
+    stats.elapsed = std::chrono::steady_clock::now() - start;
+    return stats;
+  }
+}
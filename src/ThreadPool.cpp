@@ -0,0 +1,89 @@
+#include <ThreadPool.h>
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads) {
+  threads = std::max<size_t>(1, threads);
+  for (size_t i = 0; i < threads; ++i) {
+    queues.push_back(std::make_unique<WorkQueue>());
+  }
+  workers.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    workers.emplace_back([this, i] { worker_loop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(state_mutex);
+    stopping = true;
+  }
+  work_available.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::submit(Task task) {
+  const size_t index = next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+  pending.fetch_add(1);
+  {
+    // Counted under the state mutex so a worker about to sleep cannot miss it, and
+    // before the push so a worker that takes the task never sees the count go negative
+    std::lock_guard lock(state_mutex);
+    queued.fetch_add(1);
+  }
+  {
+    std::lock_guard lock(queues[index]->mutex);
+    queues[index]->tasks.push_back(std::move(task));
+  }
+  work_available.notify_one();
+}
+
+void ThreadPool::wait() {
+  std::unique_lock lock(state_mutex);
+  all_done.wait(lock, [this] { return pending.load() == 0; });
+}
+
+bool ThreadPool::try_pop(size_t index, Task& task) {
+  WorkQueue& q = *queues[index];
+  std::lock_guard lock(q.mutex);
+  if (q.tasks.empty()) {
+    return false;
+  }
+  task = std::move(q.tasks.back());
+  q.tasks.pop_back();
+  return true;
+}
+
+bool ThreadPool::try_steal(size_t index, Task& task) {
+  for (size_t i = 1; i < queues.size(); ++i) {
+    WorkQueue& q = *queues[(index + i) % queues.size()];
+    std::lock_guard lock(q.mutex);
+    if (!q.tasks.empty()) {
+      task = std::move(q.tasks.front());
+      q.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::worker_loop(size_t index) {
+  while (true) {
+    Task task;
+    if (try_pop(index, task) || try_steal(index, task)) {
+      queued.fetch_sub(1);
+      task(index);
+      if (pending.fetch_sub(1) == 1) {
+        std::lock_guard lock(state_mutex);
+        all_done.notify_all();
+      }
+      continue;
+    }
+    std::unique_lock lock(state_mutex);
+    work_available.wait(lock, [this] { return stopping || queued.load() > 0; });
+    if (stopping && queued.load() == 0) {
+      return;
+    }
+  }
+}
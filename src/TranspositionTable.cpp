@@ -0,0 +1,159 @@
+#include <TranspositionTable.h>
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+  constexpr size_t huge_page_size = 2 * 1024 * 1024;
+  constexpr unsigned age_bits = 6;
+  constexpr uint8_t age_mask = (1 << age_bits) - 1;
+
+  // Data word layout: move in bits 0-15, score 16-31, depth 32-39, bound 40-41, age 42-47
+  constexpr uint64_t pack(PackedMove move, int score, int depth, Bound bound, uint8_t age) {
+    return uint64_t{move.raw()} | uint64_t{static_cast<uint16_t>(score)} << 16 |
+           uint64_t{static_cast<uint8_t>(depth)} << 32 | uint64_t{static_cast<uint8_t>(bound)} << 40 |
+           uint64_t{age} << 42;
+  }
+
+  constexpr PackedMove data_move(uint64_t data) { return PackedMove::from_raw(static_cast<uint16_t>(data)); }
+  constexpr int data_score(uint64_t data) { return static_cast<int16_t>(data >> 16); }
+  constexpr int data_depth(uint64_t data) { return static_cast<int8_t>(data >> 32); }
+  constexpr Bound data_bound(uint64_t data) { return static_cast<Bound>((data >> 40) & 3); }
+  constexpr uint8_t data_age(uint64_t data) { return (data >> 42) & age_mask; }
+}
+
+TTStats& TTStats::operator+=(const TTStats& other) {
+  probes += other.probes;
+  hits += other.hits;
+  collisions += other.collisions;
+  stores += other.stores;
+  overwrites += other.overwrites;
+  return *this;
+}
+
+void TranspositionTable::Free::operator()(Bucket* b) const {
+  std::free(b);
+}
+
+TranspositionTable::TranspositionTable(size_t size_mb, bool huge_pages) : huge_pages(huge_pages) {
+  resize(size_mb);
+}
+
+void TranspositionTable::resize(size_t size_mb) {
+  buckets.reset();
+  bucket_count = std::bit_floor(std::max<size_t>(1, (size_mb << 20) / sizeof(Bucket)));
+  mask = bucket_count - 1;
+
+  const size_t bytes = bucket_count * sizeof(Bucket);
+  const size_t alignment = huge_pages && bytes >= huge_page_size ? huge_page_size : alignof(Bucket);
+  void* memory = std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (alignment == huge_page_size) {
+    // Only a hint, the table works the same when the kernel declines
+    madvise(memory, bytes, MADV_HUGEPAGE);
+  }
+#endif
+  buckets.reset(static_cast<Bucket*>(memory));
+  std::uninitialized_value_construct_n(buckets.get(), bucket_count);
+  generation.store(0, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear() {
+  for (size_t i = 0; i < bucket_count; ++i) {
+    for (Entry& e : buckets[i].entries) {
+      e.key_xor_data.store(0, std::memory_order_relaxed);
+      e.data.store(0, std::memory_order_relaxed);
+    }
+  }
+  generation.store(0, std::memory_order_relaxed);
+}
+
+void TranspositionTable::new_search() {
+  generation.store((generation.load(std::memory_order_relaxed) + 1) & age_mask, std::memory_order_relaxed);
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry, TTStats* stats) const {
+  const Bucket& bucket = buckets[key & mask];
+  bool occupied = false;
+  for (const Entry& e : bucket.entries) {
+    const uint64_t data = e.data.load(std::memory_order_relaxed);
+    if (data_bound(data) == Bound::None) {
+      continue;
+    }
+    occupied = true;
+    if ((e.key_xor_data.load(std::memory_order_relaxed) ^ data) == key) {
+      entry = {data_move(data), data_score(data), data_depth(data), data_bound(data)};
+      if (stats) {
+        stats->probes++;
+        stats->hits++;
+      }
+      return true;
+    }
+  }
+  if (stats) {
+    stats->probes++;
+    stats->collisions += occupied;
+  }
+  return false;
+}
+
+void TranspositionTable::store(uint64_t key, PackedMove move, int score, int depth, Bound bound, TTStats* stats) {
+  Bucket& bucket = buckets[key & mask];
+  const uint8_t current = generation.load(std::memory_order_relaxed);
+  Entry* victim = nullptr;
+  int victim_value = 0;
+  uint64_t victim_data = 0;
+  for (Entry& e : bucket.entries) {
+    const uint64_t data = e.data.load(std::memory_order_relaxed);
+    if (data_bound(data) != Bound::None && (e.key_xor_data.load(std::memory_order_relaxed) ^ data) == key) {
+      if (bound != Bound::Exact && depth < data_depth(data) && data_age(data) == current) {
+        return;
+      }
+      if (!move) {
+        move = data_move(data);
+      }
+      victim = &e;
+      victim_data = 0;
+      break;
+    }
+    // Prefer empty slots, then results from older searches, then shallow ones
+    const int value = data_bound(data) == Bound::None
+                        ? -1024
+                        : data_depth(data) - 8 * ((current - data_age(data)) & age_mask);
+    if (!victim || value < victim_value) {
+      victim = &e;
+      victim_value = value;
+      victim_data = data;
+    }
+  }
+
+  const uint64_t data = pack(move, score, depth, bound, current);
+  victim->key_xor_data.store(key ^ data, std::memory_order_relaxed);
+  victim->data.store(data, std::memory_order_relaxed);
+  if (stats) {
+    stats->stores++;
+    stats->overwrites += data_bound(victim_data) != Bound::None && data_age(victim_data) == current;
+  }
+}
+
+int TranspositionTable::hashfull() const {
+  const size_t sample = std::min<size_t>(bucket_count, 1000 / bucket_size);
+  const uint8_t current = generation.load(std::memory_order_relaxed);
+  int used = 0;
+  for (size_t i = 0; i < sample; ++i) {
+    for (const Entry& e : buckets[i].entries) {
+      const uint64_t data = e.data.load(std::memory_order_relaxed);
+      used += data_bound(data) != Bound::None && data_age(data) == current;
+    }
+  }
+  return static_cast<int>(used * 1000 / (sample * bucket_size));
+}
@@ -0,0 +1,337 @@
+#include <Uci.h>
+#include <Perft.h>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+namespace {
+  using std::chrono::milliseconds;
+
+  constexpr size_t default_hash_mb = 64;
+  constexpr size_t max_hash_mb = 65536;
+  constexpr size_t max_threads = 256;
+  // Assumed moves left in the game when the GUI does not send movestogo
+  constexpr int default_moves_to_go = 30;
+  // Kept back from the clock for the time the GUI needs to receive the move
+  constexpr milliseconds move_overhead{30};
+  const std::string start_fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+  std::optional<PackedMove> parse_move(ChessGame& game, const std::string& uci) {
+    MoveList moves;
+    game.generate_legal_moves(moves);
+    for (const PackedMove m : moves) {
+      if (m.to_string() == uci) {
+        return m;
+      }
+    }
+    return std::nullopt;
+  }
+
+  std::string lowercase(std::string s) {
+    std::ranges::transform(s, s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+  }
+
+  std::string move_string(PackedMove m) {
+    return m == PackedMove{} ? "0000" : m.to_string();
+  }
+
+  std::string score_string(int score) {
+    if (!Search::is_mate_score(score)) {
+      return std::format("cp {}", score);
+    }
+    const int moves = (Search::mate_score - std::abs(score) + 1) / 2;
+    return std::format("mate {}", score > 0 ? moves : -moves);
+  }
+
+  std::string info_line(const SearchResult& r, int hashfull) {
+    const auto ms = r.elapsed.count();
+    std::string line = std::format("info depth {} score {} nodes {} nps {} time {} hashfull {}", r.depth,
+                                   score_string(r.score), r.nodes, r.nodes * 1000 / std::max<uint64_t>(ms, 1), ms,
+                                   hashfull);
+    if (!r.pv.empty()) {
+      line += " pv";
+      for (const PackedMove m : r.pv) {
+        line += ' ' + m.to_string();
+      }
+    }
+    return line;
+  }
+
+  milliseconds allot_time(milliseconds remaining, milliseconds increment, int moves_to_go) {
+    const milliseconds budget = remaining / std::max(moves_to_go, 1) + increment * 3 / 4;
+    return std::clamp(budget, milliseconds{1}, std::max(remaining - move_overhead, milliseconds{1}));
+  }
+}
+
+UciEngine::UciEngine(std::istream& in, std::ostream& out)
+: in(in)
+, out(out)
+, tt(default_hash_mb)
+, search(tt, threads)
+, game(std::make_unique<ChessGame>()) {}
+
+UciEngine::~UciEngine() {
+  stop_search();
+}
+
+void UciEngine::loop() {
+  for (std::string line; std::getline(in, line);) {
+    if (!execute(line)) {
+      return;
+    }
+  }
+  stop_search();
+}
+
+bool UciEngine::execute(const std::string& line) {
+  std::istringstream args(line);
+  std::string command;
+  args >> command;
+  if (command == "uci") {
+    uci();
+  } else if (command == "isready") {
+    send("readyok");
+  } else if (command == "ucinewgame") {
+    stop_search();
+    tt.clear();
+  } else if (command == "setoption") {
+    set_option(args);
+  } else if (command == "position") {
+    position(args);
+  } else if (command == "go") {
+    go(args);
+  } else if (command == "stop") {
+    stop_search();
+  } else if (command == "perft") {
+    int depth = 0;
+    args >> depth;
+    perft(depth);
+  } else if (command == "quit") {
+    stop_search();
+    return false;
+  } else if (!command.empty()) {
+    send("info string unknown command " + command);
+  }
+  return true;
+}
+
+void UciEngine::wait_for_search() {
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+void UciEngine::uci() {
+  send("id name ChessEngine");
+  send("id author ChessEngine developers");
+  send(std::format("option name Hash type spin default {} min 1 max {}", default_hash_mb, max_hash_mb));
+  send(std::format("option name Threads type spin default 1 min 1 max {}", max_threads));
+  send("option name EvalFile type string default <empty>");
+  send("option name BookFile type string default <empty>");
+  send("option name TablebasePath type string default <empty>");
+  send("uciok");
+}
+
+void UciEngine::set_option(std::istringstream& args) {
+  std::string token;
+  std::string name;
+  std::string value;
+  args >> token;
+  while (args >> token && token != "value") {
+    name += (name.empty() ? "" : " ") + token;
+  }
+  while (args >> token) {
+    value += (value.empty() ? "" : " ") + token;
+  }
+  name = lowercase(name);
+
+  stop_search();
+  try {
+    if (name == "hash") {
+      tt.resize(std::clamp<size_t>(std::stoul(value), 1, max_hash_mb));
+    } else if (name == "threads") {
+      threads = std::clamp<size_t>(std::stoul(value), 1, max_threads);
+      search.set_threads(threads);
+    } else if (name == "evalfile") {
+      network.reset();
+      if (!value.empty() && value != "<empty>") {
+        network = std::make_unique<Nnue::Network>(value);
+      }
+      game->set_network(network.get());
+    } else if (name == "bookfile") {
+      book.reset();
+      if (!value.empty() && value != "<empty>") {
+        book = std::make_unique<Polyglot::Book>(value);
+      }
+    } else if (name == "tablebasepath") {
+      search.set_tablebases(nullptr);
+      tablebases.reset();
+      if (!value.empty() && value != "<empty>") {
+        tablebases = std::make_unique<Tablebase::Tablebases>();
+        send(std::format("info string loaded {} tablebases", tablebases->load_directory(value)));
+        search.set_tablebases(tablebases.get());
+      }
+    } else {
+      send("info string unknown option " + name);
+    }
+  } catch (const std::exception& e) {
+    send(std::format("info string cannot set {}: {}", name, e.what()));
+  }
+}
+
+void UciEngine::position(std::istringstream& args) {
+  std::string token;
+  std::string fen;
+  args >> token;
+  if (token == "startpos") {
+    fen = start_fen;
+    args >> token;
+  } else if (token == "fen") {
+    // Clocks and other trailing fields may be left out
+    std::vector<std::string> fields;
+    while (args >> token && token != "moves") {
+      fields.push_back(token);
+    }
+    const std::array<std::string, 6> defaults = {"", "w", "-", "-", "0", "1"};
+    for (size_t i = fields.size(); i < defaults.size(); ++i) {
+      fields.push_back(defaults[i]);
+    }
+    for (size_t i = 0; i < defaults.size(); ++i) {
+      fen += (i ? " " : "") + fields[i];
+    }
+  } else {
+    send("info string position needs startpos or fen");
+    return;
+  }
+
+  stop_search();
+  std::unique_ptr<ChessGame> next;
+  try {
+    next = std::make_unique<ChessGame>(fen);
+  } catch (const std::exception& e) {
+    send(std::format("info string invalid fen {}: {}", fen, e.what()));
+    return;
+  }
+  // Fen accepts partial boards, the search needs a king on each side and the side that just moved out of check
+  const GameBoard& board = next->get_board();
+  const Color us = next->get_current_turn();
+  if (popcount(board.pieces(White, King)) != 1 || popcount(board.pieces(Black, King)) != 1) {
+    send(std::format("info string invalid fen {}: each side needs exactly one king", fen));
+    return;
+  }
+  if (board.pieces(us == White ? Black : White, King) & next->attacked_squares(us)) {
+    send(std::format("info string invalid fen {}: the side not to move is in check", fen));
+    return;
+  }
+  if (token == "moves") {
+    while (args >> token) {
+      const auto m = parse_move(*next, token);
+      if (!m) {
+        send("info string illegal move " + token);
+        break;
+      }
+      next->apply_move(*m);
+    }
+  }
+  next->set_network(network.get());
+  game = std::move(next);
+}
+
+void UciEngine::go(std::istringstream& args) {
+  SearchLimits limits;
+  bool infinite = false;
+  milliseconds time[2]{};
+  milliseconds increment[2]{};
+  int moves_to_go = default_moves_to_go;
+  int value = 0;
+  for (std::string token; args >> token;) {
+    if (token == "perft") {
+      args >> value;
+      perft(value);
+      return;
+    }
+    if (token == "infinite") {
+      infinite = true;
+    } else if (token == "depth" && args >> value) {
+      limits.depth = std::clamp(value, 1, Search::max_ply - 1);
+    } else if (token == "nodes") {
+      args >> limits.nodes;
+    } else if (token == "movetime" && args >> value) {
+      limits.move_time = milliseconds{std::max(value, 1)};
+    } else if (token == "wtime" && args >> value) {
+      time[0] = milliseconds{value};
+    } else if (token == "btime" && args >> value) {
+      time[1] = milliseconds{value};
+    } else if (token == "winc" && args >> value) {
+      increment[0] = milliseconds{value};
+    } else if (token == "binc" && args >> value) {
+      increment[1] = milliseconds{value};
+    } else if (token == "movestogo" && args >> value) {
+      moves_to_go = value;
+    }
+  }
+  const size_t us = GameBoard::color_index(game->get_current_turn());
+  if (!infinite && limits.move_time.count() == 0 && time[us].count() > 0) {
+    limits.move_time = allot_time(time[us], increment[us], moves_to_go);
+  }
+
+  stop_search();
+  if (!infinite && book) {
+    if (const auto m = book->pick(*game, Polyglot::Selection::Weighted, book_rng)) {
+      send("bestmove " + PackedMove(*m, false).to_string());
+      return;
+    }
+  }
+  stop_flag.store(false);
+  limits.stop = &stop_flag;
+  worker = std::thread([this, limits, infinite] {
+    const SearchResult result = search.run(*game, limits, [this](const SearchResult& r) {
+      send(info_line(r, tt.hashfull()));
+    });
+    // UCI forbids a bestmove before stop during an infinite search, even one that ended
+    if (infinite) {
+      std::unique_lock lock(stop_mutex);
+      stop_cv.wait(lock, [this] { return stop_flag.load(); });
+    }
+    std::string line = "bestmove " + move_string(result.best_move);
+    if (result.pv.size() > 1) {
+      line += " ponder " + result.pv[1].to_string();
+    }
+    send(line);
+  });
+}
+
+void UciEngine::perft(int depth) {
+  if (depth < 1) {
+    send("info string perft needs a depth of at least 1");
+    return;
+  }
+  stop_search();
+  uint64_t total = 0;
+  for (const auto& [move, nodes] : parallel_perft_divide(*game, depth, threads)) {
+    send(std::format("{}: {}", move.to_string(), nodes));
+    total += nodes;
+  }
+  send("");
+  send(std::format("Nodes searched: {}", total));
+}
+
+void UciEngine::stop_search() {
+  {
+    std::lock_guard lock(stop_mutex);
+    stop_flag.store(true);
+  }
+  stop_cv.notify_all();
+  wait_for_search();
+}
+
+void UciEngine::send(const std::string& line) {
+  std::lock_guard lock(out_mutex);
+  out << line << '\n' << std::flush;
+}
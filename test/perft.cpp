@@ -4,56 +4,76 @@
 
 #include <gtest/gtest.h>
 #include <ChessGame.h>
+#include <Perft.h>
 #include <chrono>
-static size_t run_game(ChessGame& game, int depth, Color turn) {
-  if (depth == 0) {
-    return 1;
-  }
-  size_t nodes{};
-  const Color next_turn = turn == White ? Black : White;
-  std::vector<Position> piece_list = game.get_piece_list();
-  for (const auto [piece, square] : piece_list) {
-    if (piece.color != turn) {
-      continue;
-    }
-    std::vector<Move> moves = std::move(game.generate_legal_moves(piece, square));
-    for (const auto m : moves) {
-      game.apply_move(m);
-      nodes += run_game(game, depth - 1, next_turn);
-      game.undo_move();
-    }
-  }
-  return nodes;
+TEST(PerfTest, StartPositionDepth5) {
+  ChessGame game;
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(perft(game, 5), 4865609);
+  const auto time = std::chrono::steady_clock::now() - start;
+  std::cout << "Time taken ms: " << std::chrono::duration_cast<std::chrono::milliseconds>(time).count() << std::endl;
 }
 
-static size_t perft_divide(ChessGame& game, int depth, Color turn) {
-  size_t total = 0;
-  const Color next_turn = (turn == White) ? Black : White;
+class PerftPositionTest : public ::testing::TestWithParam<std::tuple<std::string, int, size_t>> {
+protected:
+  PerftPositionTest() = default;
+};
 
-  auto piece_list = game.get_piece_list();
-  for (const auto& [piece, square] : piece_list) {
-    if (piece.color != turn) {
-      continue;
-    }
-    auto moves = game.generate_legal_moves(piece, square);
-    for (const auto& m : moves) {
-      game.apply_move(m);
-      size_t count = run_game(game, depth - 1, next_turn);
-      total += count;
-      std::cout << m.from.to_string() << ":" << m.to.to_string() << " " << count << std::endl;
-      game.undo_move();
+TEST_P(PerftPositionTest, NodeCountMatches) {
+  const auto [fen, depth, expected] = GetParam();
+  ChessGame game(fen);
+  EXPECT_EQ(perft(game, depth), expected);
+}
+
+TEST_P(PerftPositionTest, ParallelNodeCountMatches) {
+  const auto [fen, depth, expected] = GetParam();
+  const ChessGame game(fen);
+  EXPECT_EQ(parallel_perft(game, depth, 4, 1), expected);
+  EXPECT_EQ(parallel_perft(game, depth, 3, 2, 1), expected);
+}
+
+TEST_P(PerftPositionTest, CachedNodeCountMatches) {
+  const auto [fen, depth, expected] = GetParam();
+  ChessGame game(fen);
+  PerftCache cache(1);
+  EXPECT_EQ(perft(game, depth + 1, &cache), perft(game, depth + 1));
+  EXPECT_EQ(perft(game, depth, &cache), expected);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  StandardPositions,
+  PerftPositionTest,
+  ::testing::Values(
+    std::make_tuple("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 3, 8902),
+    std::make_tuple("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3, 97862),
+    std::make_tuple("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 4, 43238),
+    std::make_tuple("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 3, 9467),
+    std::make_tuple("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3, 62379),
+    std::make_tuple("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 3, 89890),
+    std::make_tuple("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 2, 707)
+    ));
+
+TEST(PerftDivideTest, ParallelDivideIsDeterministic) {
+  ChessGame game("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+  const auto serial = perft_divide(game, 3);
+  for (const size_t threads : {1, 2, 5}) {
+    const auto parallel = parallel_perft_divide(game, 3, threads, 2);
+    ASSERT_EQ(parallel.size(), serial.size());
+    for (size_t i = 0; i < serial.size(); ++i) {
+      EXPECT_EQ(parallel[i].move, serial[i].move);
+      EXPECT_EQ(parallel[i].nodes, serial[i].nodes);
     }
   }
-
-  return total;
 }
-TEST(PerfTest, Depth1) {
+
+TEST(ChessGameCopyTest, CopiesAreIndependent) {
   ChessGame game;
-  int depth = 5;
-  auto start = std::chrono::system_clock::now();
-  std::cout << run_game(game, depth, White);
-  auto end = std::chrono::system_clock::now();
-  auto time = end - start;
-  std::cout << "Time taken sec: " << std::chrono::duration_cast<std::chrono::seconds>(time).count() << std::endl;
-  std::cout << "Time taken min: " << std::chrono::duration_cast<std::chrono::minutes>(time).count() << std::endl;
+  ChessGame copy(game);
+  MoveList moves;
+  copy.generate_legal_moves(moves);
+  copy.apply_move(moves[0]);
+  EXPECT_NE(copy.key(), game.key());
+  EXPECT_EQ(perft(game, 2), 400);
+  copy.undo_move();
+  EXPECT_EQ(copy.key(), game.key());
 }
@@ -27,6 +27,31 @@ TEST_F(GameLogicTest, LoadBoardTest) {
   ASSERT_EQ(game.to_fen_piece_placement(), first);
 }
 
+TEST(GameBoardTest, BitboardsTrackMoveAndUndo) {
+  GameBoard board("8/8/8/3p4/4P3/8/8/8");
+  const Square e4{Rank_4, File_E};
+  const Square d5{Rank_5, File_D};
+  ASSERT_EQ(board.pieces(White, Pawn), square_bb(to_index(e4)));
+  ASSERT_TRUE(board.move_piece(Piece{Pawn, White}, Move{e4, d5}));
+  EXPECT_EQ(board.pieces(White, Pawn), square_bb(to_index(d5)));
+  EXPECT_EQ(board.pieces(Black, Pawn), 0);
+  EXPECT_EQ(board.occupancy(), square_bb(to_index(d5)));
+  ASSERT_TRUE(board.undo_last_move());
+  EXPECT_EQ(board.pieces(White, Pawn), square_bb(to_index(e4)));
+  EXPECT_EQ(board.pieces(Black, Pawn), square_bb(to_index(d5)));
+  EXPECT_EQ(board.to_fen_piece_placement(), "8/8/8/3p4/4P3/8/8/8");
+}
+
+TEST(GameBoardTest, SetPieceReplacesOccupant) {
+  GameBoard board;
+  const Square d1{Rank_1, File_D};
+  board.set_piece(Piece{Knight, Black}, d1);
+  EXPECT_EQ(board.pieces(White, Queen), 0);
+  EXPECT_EQ(board.pieces(Black, Knight) & square_bb(to_index(d1)), square_bb(to_index(d1)));
+  EXPECT_EQ(popcount(board.pieces(White)), 15);
+  EXPECT_EQ(board.get_piece_list().size(), 32);
+}
+
 TEST_P(ChessGameTest, ConstructChessGameFromFen) {
   auto fen_str = GetParam();
   ASSERT_NO_THROW(ChessGame{fen_str});
@@ -46,6 +71,18 @@ TEST_P(GameLogicTest, isCheckTest) {
   }
 }
 
+TEST_P(ChessGameTest, AttackedSquaresMatchesPerSquareQuery) {
+  ChessGame game(GetParam());
+  const Color them = game.get_current_turn() == White ? Black : White;
+  Bitboard expected{};
+  for (int sq = 0; sq < 64; ++sq) {
+    if (game.is_check(to_square(sq))) {
+      expected |= square_bb(sq);
+    }
+  }
+  EXPECT_EQ(game.attacked_squares(them), expected);
+}
+
 INSTANTIATE_TEST_SUITE_P(canConstructFromFen, ChessGameTest, ::testing::Values(
   "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
   "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 2 3",
@@ -54,7 +91,9 @@ INSTANTIATE_TEST_SUITE_P(canConstructFromFen, ChessGameTest, ::testing::Values(
   "4k3/8/8/8/8/8/8/4K3 w - - 0 1",
   "r3k2r/8/8/8/8/8/8/R3K2R w KQ - 0 1",
   "r3k2r/8/8/8/8/8/8/R3K2R b kq - 0 1",
-  "8/8/8/8/8/8/8/4K3 w - - 99 999"));
+  "8/8/8/8/8/8/8/4K3 w - - 99 999",
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+  "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 b kq - 0 1"));
 
 INSTANTIATE_TEST_SUITE_P(
   isCheckTests,
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <BatchAnalysis.h>
+#include <ChessGame.h>
+#include <sstream>
+
+namespace {
+  struct Known {
+    std::string line;
+    size_t moves;
+  };
+
+  const std::vector<Known> known = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 20},
+    {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - bm e2a6; id \"kiwipete\";", 48},
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 14},
+    {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - hmvc 1; fmvn 8;", 44},
+  };
+
+  std::vector<std::string> lines(const std::string& output) {
+    std::vector<std::string> result;
+    std::istringstream stream(output);
+    for (std::string line; std::getline(stream, line);) {
+      result.push_back(line);
+    }
+    return result;
+  }
+}
+
+TEST(BatchAnalysisTest, EpdToFen) {
+  std::string error;
+  EXPECT_EQ(epd_to_fen("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - hmvc 1; fmvn 8;", error),
+            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8");
+  EXPECT_EQ(epd_to_fen("8/8/8/8/8/8/8/K6k b - -  bm Kb2;", error), "8/8/8/8/8/8/8/K6k b - - 0 1");
+  EXPECT_EQ(epd_to_fen("  8/8/8/4p3/8/8/8/K6k w - e6 12 40", error), "8/8/8/4p3/8/8/8/K6k w - e6 12 40");
+
+  for (const std::string_view bad : {"8/8/8/8/8/8/8/K6k w -",
+                                     "8/8/8/8/8/8/8/K7k w - - 0 1",
+                                     "8/8/8/8/8/8/K6k w - - 0 1",
+                                     "8/8/8/8/8/8/8/K6x w - - 0 1",
+                                     "8/8/8/8/8/8/8/K7 w - - 0 1",
+                                     "8/8/8/8/8/8/8/K6k x - - 0 1",
+                                     "8/8/8/8/8/8/8/K6k w KX - 0 1",
+                                     "8/8/8/8/8/8/8/K6k w - e4 0 1"}) {
+    error.clear();
+    EXPECT_EQ(epd_to_fen(bad, error), "") << bad;
+    EXPECT_FALSE(error.empty()) << bad;
+  }
+}
+
+TEST(BatchAnalysisTest, OutputKeepsInputOrder) {
+  std::string input = "# comment\n\n";
+  std::vector<const Known*> expected;
+  for (size_t i = 0; i < 3000; ++i) {
+    const Known& k = known[(i * 7) % known.size()];
+    input += k.line + "\n";
+    expected.push_back(&k);
+  }
+  std::istringstream in(input);
+  std::ostringstream out;
+  BatchOptions options;
+  options.threads = 4;
+  options.chunk_lines = 7;
+  options.max_chunks_in_flight = 3;
+  const BatchStats stats = analyse_batch(in, out, options);
+  EXPECT_EQ(stats.positions, expected.size());
+  EXPECT_EQ(stats.errors, 0u);
+
+  const auto output = lines(out.str());
+  ASSERT_EQ(output.size(), expected.size());
+  for (size_t i = 0; i < output.size(); ++i) {
+    ASSERT_EQ(output[i], expected[i]->line + "\t" + std::to_string(expected[i]->moves)) << i;
+  }
+}
+
+TEST(BatchAnalysisTest, PerftAndEvaluate) {
+  std::istringstream in(known[1].line + "\n" + known[2].line + "\n");
+  std::ostringstream out;
+  BatchOptions options;
+  options.operation = BatchOperation::Perft;
+  options.depth = 2;
+  options.threads = 2;
+  analyse_batch(in, out, options);
+  EXPECT_EQ(lines(out.str()), (std::vector<std::string>{known[1].line + "\t2039", known[2].line + "\t191"}));
+
+  const std::string fen = "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 b - - 0 10";
+  std::istringstream eval_in(fen + "\n");
+  std::ostringstream eval_out;
+  options.operation = BatchOperation::Evaluate;
+  analyse_batch(eval_in, eval_out, options);
+  PawnTable pawns;
+  EXPECT_EQ(eval_out.str(), fen + "\t" + std::to_string(ChessGame(fen).evaluate(&pawns)) + "\n");
+}
+
+TEST(BatchAnalysisTest, ErrorsAreReportedInPlace) {
+  std::istringstream in(known[0].line + "\nnot a position\n" + known[2].line + "\n");
+  std::ostringstream out;
+  const BatchStats stats = analyse_batch(in, out, BatchOptions{});
+  EXPECT_EQ(stats.positions, 3u);
+  EXPECT_EQ(stats.errors, 1u);
+  const auto output = lines(out.str());
+  ASSERT_EQ(output.size(), 3u);
+  EXPECT_EQ(output[1].rfind("not a position\terror: ", 0), 0u) << output[1];
+  EXPECT_EQ(output[2], known[2].line + "\t14");
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <ChessGame.h>
+#include <PositionSnapshot.h>
+
+namespace {
+  const std::vector<std::string> fens = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+  };
+
+  void recompute(const GameBoard& board, Eval::Score& psq, int& phase) {
+    psq = {};
+    phase = 0;
+    Bitboard occupied = board.occupancy();
+    while (occupied) {
+      const int sq = pop_lsb(occupied);
+      const Piece p = board.at(to_square(sq));
+      psq += Eval::psqt[GameBoard::piece_index(p)][sq];
+      phase += Eval::phase_weight[p.type];
+    }
+  }
+
+  void walk(ChessGame& game, const PositionSnapshot& snapshot, int depth, int& nodes) {
+    Eval::Score psq;
+    int phase;
+    recompute(game.get_board(), psq, phase);
+    ASSERT_EQ(game.get_board().psq_score(), psq);
+    ASSERT_EQ(game.get_board().game_phase(), phase);
+    ASSERT_EQ(snapshot.psq_score(), psq);
+    ASSERT_EQ(snapshot.game_phase(), phase);
+    nodes++;
+    if (depth == 0) {
+      return;
+    }
+    MoveList moves;
+    game.generate_legal_moves(moves);
+    for (const PackedMove m : moves) {
+      game.apply_move(m);
+      walk(game, snapshot.make_move(m), depth - 1, nodes);
+      game.undo_move();
+    }
+  }
+}
+
+TEST(EvaluationTest, IncrementalTermsMatchRecomputation) {
+  for (const auto& fen : fens) {
+    ChessGame game(fen);
+    const Eval::Score before = game.get_board().psq_score();
+    int nodes = 0;
+    walk(game, game.snapshot(), 3, nodes);
+    EXPECT_GT(nodes, 1000) << fen;
+    EXPECT_EQ(game.get_board().psq_score(), before) << fen;
+  }
+}
+
+TEST(EvaluationTest, StartingPositionIsBalanced) {
+  ChessGame game;
+  EXPECT_EQ(game.get_board().game_phase(), Eval::max_phase);
+  EXPECT_EQ(game.get_board().psq_score(), Eval::Score{});
+  EXPECT_EQ(game.get_board().evaluate(White), 0);
+}
+
+TEST(EvaluationTest, MirroredPositionsScoreTheSame) {
+  // Colors swapped and ranks flipped, so each side to move sees the same position
+  ChessGame white("r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4");
+  ChessGame black("rnbqk2r/pppp1ppp/5n2/2b1p3/4P3/2N2N2/PPPP1PPP/R1BQKB1R b KQkq - 4 4");
+  EXPECT_EQ(white.get_board().evaluate(White), black.get_board().evaluate(Black));
+  EXPECT_EQ(white.get_board().evaluate(Black), -white.get_board().evaluate(White));
+}
+
+TEST(EvaluationTest, PhaseTapersTowardsTheEndgame) {
+  // A king in the centre is bad with queens on and good without them
+  ChessGame middlegame("rnbq1bnr/pppppppp/8/8/4K3/8/PPPPPPPP/RNBQ1BNR w - - 0 1");
+  ChessGame endgame("8/8/8/8/4K3/8/8/k7 w - - 0 1");
+  EXPECT_EQ(endgame.get_board().game_phase(), 0);
+  EXPECT_LT(Eval::taper(Eval::psqt[GameBoard::piece_index({King, White})][to_index(Square{Rank_4, File_E})],
+                        middlegame.get_board().game_phase()), 0);
+  EXPECT_GT(endgame.get_board().evaluate(White), 0);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <ChessGame.h>
+#include <Fen.h>
+
+class FenRoundTripTest : public ::testing::TestWithParam<std::string> {
+protected:
+  FenRoundTripTest() = default;
+};
+
+TEST_P(FenRoundTripTest, ParseThenSerializeGivesTheSameFen) {
+  const auto position = Fen::parse(GetParam());
+  ASSERT_TRUE(position.has_value()) << Fen::message(position.error());
+  EXPECT_EQ(Fen::to_string(*position), GetParam());
+}
+
+TEST_P(FenRoundTripTest, GameSerializesItsFullState) {
+  const ChessGame game(GetParam());
+  EXPECT_EQ(game.to_fen(), GetParam());
+  EXPECT_EQ(game.key(), game.compute_key());
+}
+
+INSTANTIATE_TEST_SUITE_P(Positions, FenRoundTripTest, ::testing::Values(
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+  "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq e6 0 2",
+  "rnbqkbnr/pppppppp/8/8/3P4/8/PPP1PPPP/RNBQKBNR b KQkq d3 0 1",
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+  "r3k2r/8/8/8/8/8/8/R3K2R b Kq - 7 40",
+  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+  "4k3/8/8/8/8/8/8/4K3 w - - 99 65535"));
+
+TEST(FenTest, ParsesEveryField) {
+  const auto position = Fen::parse("r3k3/8/8/3pP3/8/8/8/4K2R w Kq d6 3 17");
+  ASSERT_TRUE(position.has_value());
+  EXPECT_EQ(position->squares[to_index({Rank_8, File_A})].type, Rook);
+  EXPECT_EQ(position->squares[to_index({Rank_8, File_A})].color, Black);
+  EXPECT_EQ(position->squares[to_index({Rank_1, File_H})].type, Rook);
+  EXPECT_EQ(position->squares[to_index({Rank_1, File_H})].color, White);
+  EXPECT_EQ(position->squares[to_index({Rank_4, File_D})].type, NoPiece);
+  EXPECT_EQ(position->side_to_move, White);
+  EXPECT_EQ(position->castling_rights, WhiteKingSide | BlackQueenSide);
+  ASSERT_TRUE(position->en_passant.has_value());
+  EXPECT_EQ(to_index(*position->en_passant), to_index({Rank_6, File_D}));
+  EXPECT_EQ(position->half_move_clock, 3);
+  EXPECT_EQ(position->full_moves, 17);
+}
+
+TEST(FenTest, ClocksAndWhitespaceAreOptional) {
+  const auto position = Fen::parse("  8/8/8/8/8/8/8/K6k \tb  -   -  ");
+  ASSERT_TRUE(position.has_value());
+  EXPECT_EQ(position->side_to_move, Black);
+  EXPECT_EQ(position->half_move_clock, 0);
+  EXPECT_EQ(position->full_moves, 1);
+  EXPECT_EQ(Fen::to_string(*position), "8/8/8/8/8/8/8/K6k b - - 0 1");
+  // Partial boards are fine, legality is left to the caller
+  EXPECT_TRUE(Fen::parse("8/8/8/8/8/8/4P3/8 w - - 0 1").has_value());
+}
+
+TEST(FenTest, DropsRightsTheBoardCannotBack) {
+  // Castling without the king or rook at home
+  for (const char* fen : {"8/8/8/8/8/8/8/K6k w KQ - 0 1", "4k3/8/8/8/8/8/8/4K3 w KQ - 0 1"}) {
+    const auto position = Fen::parse(fen);
+    ASSERT_TRUE(position.has_value()) << fen;
+    EXPECT_EQ(position->castling_rights, 0) << fen;
+  }
+  const auto moved_rook = Fen::parse("r3k2r/8/8/8/8/8/8/R3K1R1 w KQkq - 0 1");
+  ASSERT_TRUE(moved_rook.has_value());
+  EXPECT_EQ(moved_rook->castling_rights, WhiteQueenSide | BlackKingSide | BlackQueenSide);
+  // Phantom double pushes: no pawn in front, the wrong side's rank, a pawn that never moved two
+  for (const char* fen : {"4k3/8/8/8/8/8/3P4/4K3 w - e3 0 1", "4k3/8/8/3P4/8/8/8/4K3 w - e6 0 1",
+                          "4k3/8/8/8/4P3/8/8/4K3 w - e3 0 1", "4k3/8/8/4p3/8/8/8/4K3 b - e6 0 1"}) {
+    const auto position = Fen::parse(fen);
+    ASSERT_TRUE(position.has_value()) << fen;
+    EXPECT_FALSE(position->en_passant.has_value()) << fen;
+  }
+  EXPECT_EQ(ChessGame("4k3/8/8/8/8/8/3P4/4K3 w - e3 0 1").to_fen(), "4k3/8/8/8/8/8/3P4/4K3 w - - 0 1");
+  EXPECT_EQ(ChessGame("8/8/8/8/8/8/8/K6k w KQ - 0 1").to_fen(), "8/8/8/8/8/8/8/K6k w - - 0 1");
+}
+
+TEST(FenTest, ReportsTheFirstBadField) {
+  const std::vector<std::pair<std::string_view, Fen::Error>> cases = {
+    {"", Fen::Error::MissingField},
+    {"8/8/8/8/8/8/8/K6k w -", Fen::Error::MissingField},
+    {"8/8/8/8/8/8/8/K7k w - - 0 1", Fen::Error::PiecePlacement},
+    {"8/8/8/8/8/8/K6k w - - 0 1", Fen::Error::PiecePlacement},
+    {"8/8/8/8/8/8/8/8/K6k w - - 0 1", Fen::Error::PiecePlacement},
+    {"8/8/8/8/8/8/8/K6x w - - 0 1", Fen::Error::PiecePlacement},
+    {"8/8/8/8/8/8/8/K6k/ w - - 0 1", Fen::Error::PiecePlacement},
+    {"4k2P/8/8/8/8/8/8/4K3 w - - 0 1", Fen::Error::PiecePlacement},
+    {"4k3/8/8/8/8/8/8/4K2p w - - 0 1", Fen::Error::PiecePlacement},
+    {"8/8/8/8/8/8/8/K6k x - - 0 1", Fen::Error::SideToMove},
+    {"8/8/8/8/8/8/8/K6k white - - 0 1", Fen::Error::SideToMove},
+    {"8/8/8/8/8/8/8/K6k w KX - 0 1", Fen::Error::Castling},
+    {"8/8/8/8/8/8/8/K6k w KK - 0 1", Fen::Error::Castling},
+    {"8/8/8/8/8/8/8/K6k w K- - 0 1", Fen::Error::Castling},
+    {"8/8/8/8/8/8/8/K6k w - e4 0 1", Fen::Error::EnPassant},
+    {"8/8/8/8/8/8/8/K6k w - i6 0 1", Fen::Error::EnPassant},
+    {"8/8/8/8/8/8/8/K6k w - e6x 0 1", Fen::Error::EnPassant},
+    {"8/8/8/8/8/8/8/K6k w - - -1 1", Fen::Error::HalfMoveClock},
+    {"8/8/8/8/8/8/8/K6k w - - 70000 1", Fen::Error::HalfMoveClock},
+    {"8/8/8/8/8/8/8/K6k w - - 0", Fen::Error::FullMoveNumber},
+    {"8/8/8/8/8/8/8/K6k w - - 0 1x", Fen::Error::FullMoveNumber},
+    {"8/8/8/8/8/8/8/K6k w - - 0 1 bm Kb2;", Fen::Error::TrailingInput},
+  };
+  for (const auto& [fen, error] : cases) {
+    const auto position = Fen::parse(fen);
+    ASSERT_FALSE(position.has_value()) << fen;
+    EXPECT_EQ(position.error(), error) << fen;
+    EXPECT_FALSE(Fen::message(position.error()).empty());
+  }
+}
+
+TEST(FenTest, GameThrowsOnBadFen) {
+  EXPECT_THROW(ChessGame("8/8/8/8/8/8/8/K6k w KX - 0 1"), std::runtime_error);
+  EXPECT_THROW(ChessGame("not a fen"), std::runtime_error);
+  EXPECT_THROW(GameBoard("8/8/8/9/8/8/8/8"), std::runtime_error);
+  EXPECT_THROW(ChessGame("4k2P/8/8/8/8/8/8/4K3 w - - 0 1"), std::runtime_error);
+}
+
+TEST(FenTest, KinglessBoardsParse) {
+  // Legality beyond the notation is up to callers, see ChessGame(std::string_view)
+  for (const char* fen : {"8/8/8/8/8/8/8/8 w - - 0 1", "4k3/8/8/8/8/8/8/8 w - - 0 1"}) {
+    const auto position = Fen::parse(fen);
+    ASSERT_TRUE(position.has_value()) << fen;
+    EXPECT_EQ(Fen::to_string(*position), fen);
+    EXPECT_NO_THROW(ChessGame{fen});
+  }
+}
+
+TEST(FenTest, ToFenFollowsMoves) {
+  ChessGame game;
+  game.apply_move(Move{{Rank_2, File_E}, {Rank_4, File_E}});
+  EXPECT_EQ(game.to_fen(), "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+  game.apply_move(Move{{Rank_8, File_G}, {Rank_6, File_F}});
+  game.apply_move(Move{{Rank_1, File_E}, {Rank_2, File_E}});
+  EXPECT_EQ(game.to_fen(), "rnbqkb1r/pppppppp/5n2/8/4P3/8/PPPPKPPP/RNBQ1BNR b kq - 2 2");
+  game.undo_move();
+  game.undo_move();
+  EXPECT_EQ(game.to_fen(), "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <ChessGame.h>
+#include <Kpk.h>
+#include <Search.h>
+#include <vector>
+
+namespace {
+  // White king, white pawn and black king on their squares
+  std::string placement(int white_king, int pawn, int black_king) {
+    std::string fen;
+    for (int rank = 7; rank >= 0; --rank) {
+      int empty = 0;
+      for (int file = 0; file < 8; ++file) {
+        const int sq = rank * 8 + file;
+        const char piece = sq == white_king ? 'K' : sq == pawn ? 'P' : sq == black_king ? 'k' : 0;
+        if (!piece) {
+          ++empty;
+          continue;
+        }
+        if (empty) {
+          fen += static_cast<char>('0' + empty);
+          empty = 0;
+        }
+        fen += piece;
+      }
+      if (empty) {
+        fen += static_cast<char>('0' + empty);
+      }
+      if (rank) {
+        fen += '/';
+      }
+    }
+    return fen;
+  }
+
+  int distance(int a, int b) {
+    return std::max(std::abs((a >> 3) - (b >> 3)), std::abs((a & 7) - (b & 7)));
+  }
+
+  size_t slot(int white_to_move, int white_king, int pawn, int black_king) {
+    return static_cast<size_t>(((white_to_move * 64 + white_king) * 64 + pawn) * 64 + black_king);
+  }
+
+  enum Value : int8_t { Unknown = -1, Draw = 0, Win = 1 };
+
+  struct Node {
+    size_t slot;
+    bool white_to_move;
+    // Outcome of a move leaving king and pawn versus king, captures and promotions
+    bool reaches_win{false};
+    bool reaches_draw{false};
+    std::vector<size_t> successors;
+  };
+
+  /**
+   * Solves every legal position with the engine's own move generator, independently of
+   * the bitbase generator. A promotion counts as won when black can neither take the new
+   * piece nor is stalemated, checked on the real position for each promotion piece.
+   */
+  std::vector<int8_t> solve(std::vector<Node>& nodes) {
+    std::vector<int8_t> values(2 * 64 * 64 * 64, Unknown);
+    for (int stm = 0; stm < 2; ++stm) {
+      for (int wk = 0; wk < 64; ++wk) {
+        for (int pawn = 8; pawn < 56; ++pawn) {
+          for (int bk = 0; bk < 64; ++bk) {
+            if (wk == pawn || bk == pawn || distance(wk, bk) <= 1
+                || (stm && (pawn_attacks(0, pawn) & square_bb(bk)))) {
+              continue;
+            }
+            const PositionSnapshot position(GameBoard(placement(wk, pawn, bk)), stm ? White : Black, 0, std::nullopt, 0, 1, 0);
+            Node node{slot(stm, wk, pawn, bk), stm == 1, false, false, {}};
+            MoveList moves;
+            position.generate_legal_moves(moves);
+            if (moves.empty()) {
+              (position.in_check() ? node.reaches_win : node.reaches_draw) = true;
+            }
+            for (const PackedMove m : moves) {
+              const PositionSnapshot next = position.make_move(m);
+              if (m.is_promotion()) {
+                MoveList replies;
+                next.generate_legal_moves(replies);
+                const bool taken = std::ranges::any_of(replies, [&](PackedMove r) { return r.to() == m.to(); });
+                const bool wins = m.promotion_piece() >= Rook && !taken && (!replies.empty() || next.in_check());
+                (wins ? node.reaches_win : node.reaches_draw) = true;
+              } else if (!next.pieces(White, Pawn)) {
+                node.reaches_draw = true;
+              } else {
+                node.successors.push_back(slot(!stm, lsb(next.pieces(White, King)), lsb(next.pieces(White, Pawn)),
+                                               lsb(next.pieces(Black, King))));
+              }
+            }
+            nodes.push_back(std::move(node));
+          }
+        }
+      }
+    }
+
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (const Node& node : nodes) {
+        if (values[node.slot] != Unknown) {
+          continue;
+        }
+        // White needs one winning move, black one drawing move
+        const Value good = node.white_to_move ? Win : Draw;
+        bool found = node.white_to_move ? node.reaches_win : node.reaches_draw;
+        bool open = false;
+        for (const size_t s : node.successors) {
+          found |= values[s] == good;
+          open |= values[s] == Unknown;
+        }
+        if (found || !open) {
+          values[node.slot] = found ? good : (good == Win ? Draw : Win);
+          changed = true;
+        }
+      }
+    }
+    return values;
+  }
+}
+
+TEST(KpkTest, MatchesExhaustiveRetrogradeSolution) {
+  std::vector<Node> nodes;
+  const std::vector<int8_t> values = solve(nodes);
+  size_t wins = 0;
+  for (const Node& node : nodes) {
+    const int stm = static_cast<int>(node.slot >> 18);
+    const int wk = static_cast<int>(node.slot >> 12 & 63);
+    const int pawn = static_cast<int>(node.slot >> 6 & 63);
+    const int bk = static_cast<int>(node.slot & 63);
+    const bool win = values[node.slot] == Win;
+    wins += win;
+    ASSERT_EQ(Kpk::probe(White, wk, pawn, bk, stm ? White : Black), win)
+      << placement(wk, pawn, bk) << (stm ? " w" : " b");
+    // The same position with colours swapped
+    ASSERT_EQ(Kpk::probe(Black, wk ^ 56, pawn ^ 56, bk ^ 56, stm ? Black : White), win);
+  }
+  EXPECT_GT(wins, nodes.size() / 2);
+}
+
+TEST(KpkTest, KnownPositions) {
+  // King on the sixth rank in front of the pawn wins whoever moves
+  EXPECT_EQ(ChessGame("4k3/8/4K3/4P3/8/8/8/8 w - - 0 1").probe_kpk(), true);
+  EXPECT_EQ(ChessGame("4k3/8/4K3/4P3/8/8/8/8 b - - 0 1").probe_kpk(), true);
+  EXPECT_EQ(ChessGame("4k3/8/3K4/8/8/8/4P3/8 b - - 0 1").probe_kpk(), true);
+  // Black to move is stalemated, white to move wins
+  EXPECT_EQ(ChessGame("4k3/4P3/4K3/8/8/8/8/8 w - - 0 1").probe_kpk(), true);
+  EXPECT_EQ(ChessGame("4k3/4P3/4K3/8/8/8/8/8 b - - 0 1").probe_kpk(), false);
+  // Rook pawn with the defending king in the corner
+  EXPECT_EQ(ChessGame("k7/8/K7/P7/8/8/8/8 w - - 0 1").probe_kpk(), false);
+  // The pawn outruns the king
+  EXPECT_EQ(ChessGame("8/8/8/1P6/8/8/7k/K7 w - - 0 1").probe_kpk(), true);
+  EXPECT_EQ(ChessGame("8/8/8/8/8/2k5/6p1/K7 b - - 0 1").probe_kpk(), true);
+  EXPECT_EQ(ChessGame("8/8/8/8/8/2k5/6p1/K7 b - - 0 1").snapshot().probe_kpk(), true);
+
+  EXPECT_FALSE(ChessGame().probe_kpk().has_value());
+  EXPECT_FALSE(ChessGame("4k3/8/4K3/4P3/4P3/8/8/8 w - - 0 1").probe_kpk().has_value());
+  EXPECT_FALSE(ChessGame("4k3/8/4K3/4N3/8/8/8/8 w - - 0 1").probe_kpk().has_value());
+}
+
+TEST(KpkTest, SearchScoresBitbaseResults) {
+  SearchLimits limits;
+  limits.depth = 1;
+  Search drawn(ChessGame("k7/8/K7/P7/8/8/8/8 w - - 0 1"));
+  EXPECT_EQ(drawn.run(limits).score, 0);
+  Search won(ChessGame("4k3/8/3K4/8/8/8/4P3/8 w - - 0 1"));
+  EXPECT_GT(won.run(limits).score, Search::known_win - 1000);
+  Search lost(ChessGame("8/8/8/8/8/2k5/6p1/K7 w - - 0 1"));
+  EXPECT_LT(lost.run(limits).score, -Search::known_win + 1000);
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <Bitboard.h>
+#include <GameTypes.h>
+#include <MoveGenerator.h>
+#include <random>
+#include <span>
+
+static Bitboard ray_attacks(std::span<const MoveDir> dirs, int sq, Bitboard occupied) {
+  Bitboard attacks = 0;
+  for (const auto& [rank_dir, file_dir] : dirs) {
+    int rank = (sq >> 3) + rank_dir;
+    int file = (sq & 7) + file_dir;
+    while (GameBoard::is_inbound(rank, file)) {
+      attacks |= square_bb(rank * 8 + file);
+      if (occupied & square_bb(rank * 8 + file)) {
+        break;
+      }
+      rank += rank_dir;
+      file += file_dir;
+    }
+  }
+  return attacks;
+}
+
+// Computed during static initialization, possibly before Bitboard.cpp's own statics
+static const Bitboard early_rook_attacks = rook_attacks(0, square_bb(3));
+static const Bitboard early_between = between_bb(0, 63);
+
+TEST(MagicBitboardTest, UsableFromOtherStaticInitializers) {
+  EXPECT_EQ(early_rook_attacks, rook_attacks(0, square_bb(3)));
+  EXPECT_EQ(early_rook_attacks, square_bb(1) | square_bb(2) | square_bb(3) | (FileABB & ~square_bb(0)));
+  EXPECT_EQ(popcount(early_between), 6);
+}
+
+TEST(MagicBitboardTest, MatchesRayWalkOnRandomOccupancy) {
+  std::mt19937_64 rng(2026);
+  for (int i = 0; i < 2000; ++i) {
+    const Bitboard occupied = rng() & rng();
+    for (int sq = 0; sq < 64; ++sq) {
+      ASSERT_EQ(bishop_attacks(sq, occupied), ray_attacks(MoveGenerator::bishop_directions, sq, occupied));
+      ASSERT_EQ(rook_attacks(sq, occupied), ray_attacks(MoveGenerator::rook_directions, sq, occupied));
+      ASSERT_EQ(queen_attacks(sq, occupied), ray_attacks(MoveGenerator::queen_directions, sq, occupied));
+    }
+  }
+}
+
+TEST(MagicBitboardTest, EmptyBoardCounts) {
+  EXPECT_EQ(popcount(rook_attacks(to_index({Rank_4, File_D}), 0)), 14);
+  EXPECT_EQ(popcount(bishop_attacks(to_index({Rank_4, File_D}), 0)), 13);
+  EXPECT_EQ(popcount(bishop_attacks(to_index({Rank_1, File_A}), 0)), 7);
+  EXPECT_EQ(popcount(queen_attacks(to_index({Rank_8, File_H}), 0)), 21);
+}
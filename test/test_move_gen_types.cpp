@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <ChessGame.h>
+#include <algorithm>
+
+namespace {
+  using GenType = MoveGenerator::GenType;
+
+  const std::vector<std::string> fens = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+  };
+
+  template<GenType T>
+  std::vector<uint16_t> generate(ChessGame& game) {
+    const GameBoard& board = game.get_board();
+    const Color us = game.get_current_turn();
+    const auto info = MoveGenerator::get_check_info(board, us);
+    MoveList list;
+    MoveGenerator::generate<T>(board, list, us, game.castling_rights(), game.en_passant_square(), info);
+    std::vector<uint16_t> raw;
+    for (const PackedMove m : list) {
+      if (MoveGenerator::is_legal(board, us, m, info)) {
+        raw.push_back(m.raw());
+      }
+    }
+    std::ranges::sort(raw);
+    return raw;
+  }
+
+  std::vector<uint16_t> legal(ChessGame& game) {
+    MoveList list;
+    game.generate_legal_moves(list);
+    std::vector<uint16_t> raw;
+    for (const PackedMove m : list) {
+      raw.push_back(m.raw());
+    }
+    std::ranges::sort(raw);
+    return raw;
+  }
+
+  void walk(ChessGame& game, int depth, int& evasion_nodes) {
+    const std::vector<uint16_t> all = legal(game);
+    if (game.in_check()) {
+      evasion_nodes++;
+      ASSERT_EQ(generate<GenType::Evasions>(game), all);
+    } else {
+      const auto captures = generate<GenType::Captures>(game);
+      const auto quiets = generate<GenType::Quiets>(game);
+      for (const uint16_t m : captures) {
+        const PackedMove move = PackedMove::from_raw(m);
+        ASSERT_TRUE(move.is_capture() || move.is_promotion());
+      }
+      for (const uint16_t m : quiets) {
+        const PackedMove move = PackedMove::from_raw(m);
+        ASSERT_FALSE(move.is_capture() || move.is_promotion());
+      }
+      std::vector<uint16_t> both;
+      std::ranges::merge(captures, quiets, std::back_inserter(both));
+      ASSERT_EQ(both, all);
+      ASSERT_EQ(generate<GenType::NonEvasions>(game), all);
+    }
+    if (depth == 0) {
+      return;
+    }
+    for (const uint16_t m : all) {
+      game.apply_move(PackedMove::from_raw(m));
+      walk(game, depth - 1, evasion_nodes);
+      game.undo_move();
+    }
+  }
+}
+
+TEST(MoveGenTypesTest, SubsetsPartitionTheLegalMoves) {
+  for (const auto& fen : fens) {
+    ChessGame game(fen);
+    int evasion_nodes = 0;
+    walk(game, 2, evasion_nodes);
+    EXPECT_GT(evasion_nodes, 0) << fen;
+  }
+}
+
+TEST(MoveGenTypesTest, EvasionsOnlyAddressTheCheck) {
+  // Rook check along the e-file: the knight can only block on e4, the king steps aside
+  ChessGame single("4r1k1/8/8/8/8/8/3N4/4K3 w - - 0 1");
+  const GameBoard& board = single.get_board();
+  const auto info = MoveGenerator::get_check_info(board, White);
+  MoveList evasions;
+  MoveGenerator::generate<GenType::Evasions>(board, evasions, White, 0, std::nullopt, info);
+  EXPECT_LT(evasions.size(), 12u);
+  const int king = to_index(Square{Rank_1, File_E});
+  const int rook = to_index(Square{Rank_8, File_E});
+  for (const PackedMove m : evasions) {
+    EXPECT_TRUE(m.from() == king || ((between_bb(king, rook) | square_bb(rook)) & square_bb(m.to()))) << m.to_string();
+  }
+  EXPECT_EQ(std::ranges::count_if(evasions, [&](PackedMove m) { return m.from() != king; }), 1);
+
+  // Double check from knight and rook leaves only king moves
+  ChessGame double_check("4r1k1/8/8/8/8/3n4/8/4K2R w K - 0 1");
+  const auto dinfo = MoveGenerator::get_check_info(double_check.get_board(), White);
+  ASSERT_EQ(popcount(dinfo.checkers), 2);
+  MoveList king_only;
+  MoveGenerator::generate<GenType::Evasions>(double_check.get_board(), king_only, White, 0, std::nullopt, dinfo);
+  ASSERT_FALSE(king_only.empty());
+  for (const PackedMove m : king_only) {
+    EXPECT_EQ(m.from(), to_index(Square{Rank_1, File_E}));
+    EXPECT_FALSE(m.is_castling());
+  }
+}
+
+TEST(MoveGenTypesTest, CastlingNeedsKingAndRookAtHome) {
+  constexpr uint8_t all_rights = WhiteKingSide | WhiteQueenSide | BlackKingSide | BlackQueenSide;
+  const auto castles = [&](std::string_view placement, Color us) {
+    MoveList list;
+    MoveGenerator::generate_legal_moves(GameBoard(placement), list, us, all_rights, std::nullopt);
+    return std::ranges::count_if(list, [](PackedMove m) { return m.is_castling(); });
+  };
+  // King in the a1 corner, where the queen side path used to index below square 0
+  EXPECT_EQ(castles("8/8/8/8/8/8/8/K6k", White), 0);
+  EXPECT_EQ(castles("K6k/8/8/8/8/8/8/8", Black), 0);
+  // Kings at home without rooks
+  EXPECT_EQ(castles("4k3/8/8/8/8/8/8/4K3", White), 0);
+  EXPECT_EQ(castles("4k3/8/8/8/8/8/8/4K3", Black), 0);
+  // Enemy rooks on the corners do not count
+  EXPECT_EQ(castles("r3k2r/8/8/8/8/8/8/r3K2r", White), 0);
+  EXPECT_EQ(castles("r3k2r/8/8/8/8/8/8/R3K3", White), 1);
+  EXPECT_EQ(castles("r3k2r/8/8/8/8/8/8/R3K2R", White), 2);
+  EXPECT_EQ(castles("4k2r/8/8/8/8/8/8/R3K2R", Black), 1);
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <MovePicker.h>
+#include <algorithm>
+
+namespace {
+  const std::vector<std::string> fens = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+  };
+
+  std::vector<uint16_t> sorted_raw(const std::vector<PackedMove>& moves) {
+    std::vector<uint16_t> raw;
+    for (const PackedMove m : moves) {
+      raw.push_back(m.raw());
+    }
+    std::ranges::sort(raw);
+    return raw;
+  }
+
+  std::vector<PackedMove> drain(MovePicker& picker) {
+    std::vector<PackedMove> out;
+    while (const PackedMove m = picker.next()) {
+      out.push_back(m);
+    }
+    return out;
+  }
+
+  // Walks the tree checking the picker against the full generator at every node. Hash
+  // and killer moves are taken from other nodes so they are often illegal here.
+  void walk(ChessGame& game, int depth, std::array<PackedMove, 3>& foreign, uint64_t& nodes) {
+    MoveList list;
+    game.generate_legal_moves(list);
+    const std::vector<PackedMove> expected(list.begin(), list.end());
+
+    MovePicker picker(game, foreign[0], {foreign[1], foreign[2]}, nullptr);
+    const std::vector<PackedMove> picked = drain(picker);
+    ASSERT_EQ(sorted_raw(picked), sorted_raw(expected)) << game.snapshot().key();
+
+    std::vector<PackedMove> tactical;
+    for (const PackedMove m : expected) {
+      if (game.in_check() || ((m.is_capture() || m.is_promotion()) && game.see_ge(m, 0))) {
+        tactical.push_back(m);
+      }
+    }
+    MovePicker qpicker(game, foreign[0]);
+    ASSERT_EQ(sorted_raw(drain(qpicker)), sorted_raw(tactical));
+
+    nodes++;
+    if (depth == 0) {
+      return;
+    }
+    for (const PackedMove m : expected) {
+      foreign = {foreign[1], foreign[2], m};
+      game.apply_move(m);
+      walk(game, depth - 1, foreign, nodes);
+      game.undo_move();
+    }
+  }
+}
+
+TEST(MovePickerTest, ReturnsEveryLegalMoveExactlyOnce) {
+  for (const auto& fen : fens) {
+    ChessGame game(fen);
+    std::array<PackedMove, 3> foreign{};
+    uint64_t nodes = 0;
+    walk(game, 2, foreign, nodes);
+    EXPECT_GT(nodes, 100u) << fen;
+  }
+}
+
+TEST(MovePickerTest, RejectsArbitraryHashMoves) {
+  ChessGame game(fens[1]);
+  MoveList list;
+  game.generate_legal_moves(list);
+  for (uint32_t raw = 0; raw < 0x10000; raw += 7) {
+    MovePicker picker(game, PackedMove::from_raw(static_cast<uint16_t>(raw)), {}, nullptr);
+    const PackedMove first = picker.next();
+    ASSERT_NE(std::ranges::find(list, first), list.end()) << raw;
+  }
+}
+
+TEST(MovePickerTest, OrdersHashCapturesKillersThenQuiets) {
+  ChessGame game(fens[1]);
+  MoveList list;
+  game.generate_legal_moves(list);
+  auto find = [&](const std::string& uci) {
+    return *std::ranges::find_if(list, [&](PackedMove m) { return m.to_string() == uci; });
+  };
+  const PackedMove hash = find("a2a3");
+  const PackedMove killer = find("g2g3");
+
+  MovePicker picker(game, hash, {killer, PackedMove{}}, nullptr);
+  const std::vector<PackedMove> picked = drain(picker);
+  ASSERT_EQ(picked.size(), list.size());
+  EXPECT_EQ(picked[0], hash);
+  // Winning and even captures, the killer, quiet moves, then losing captures
+  const auto first_quiet = std::ranges::find_if(picked.begin() + 1, picked.end(),
+                                                [](PackedMove m) { return !m.is_capture(); });
+  const auto first_bad = std::ranges::find_if(first_quiet, picked.end(),
+                                              [](PackedMove m) { return m.is_capture(); });
+  ASSERT_NE(first_quiet, picked.end());
+  ASSERT_NE(first_bad, picked.end());
+  EXPECT_EQ(*first_quiet, killer);
+  EXPECT_TRUE(std::all_of(picked.begin() + 1, first_quiet, [&](PackedMove m) { return game.see_ge(m, 0); }));
+  EXPECT_TRUE(std::none_of(first_quiet, first_bad, [](PackedMove m) { return m.is_capture(); }));
+  EXPECT_TRUE(std::none_of(first_bad, picked.end(), [&](PackedMove m) { return game.see_ge(m, 0); }));
+  // Bishop takes bishop is the most valuable capture
+  EXPECT_EQ(picked[1].to_string(), "e2a6");
+}
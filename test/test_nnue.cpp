@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <ChessGame.h>
+#include <Nnue.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace {
+  // Writes a network with small random weights so accumulators stay far from overflow
+  std::string write_network(const std::string& path, uint32_t version) {
+    std::ofstream out(path, std::ios::binary);
+    const uint32_t header[3] = {version, Nnue::feature_count, Nnue::hidden_size};
+    out.write("NNUE", 4);
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    std::mt19937 rng(2024);
+    std::uniform_int_distribution<int> weight(-40, 40);
+    std::vector<int16_t> values(Nnue::hidden_size + Nnue::feature_count * Nnue::hidden_size + 2 * Nnue::hidden_size);
+    for (auto& v : values) {
+      v = static_cast<int16_t>(weight(rng));
+    }
+    out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(int16_t)));
+    const int32_t bias = 1234;
+    out.write(reinterpret_cast<const char*>(&bias), sizeof(bias));
+    return path;
+  }
+
+  std::vector<Nnue::Simd> supported_simd() {
+    std::vector<Nnue::Simd> all = {Nnue::Simd::Scalar};
+    if (Nnue::detect_simd() != Nnue::Simd::Scalar) {
+      all.push_back(Nnue::Simd::Sse2);
+    }
+    if (Nnue::detect_simd() == Nnue::Simd::Avx2) {
+      all.push_back(Nnue::Simd::Avx2);
+    }
+    return all;
+  }
+
+  int refreshed_eval(const Nnue::Network& net, const ChessGame& game) {
+    Nnue::Accumulator acc{};
+    net.refresh(acc, White, game.get_board());
+    net.refresh(acc, Black, game.get_board());
+    return net.evaluate(acc, game.get_current_turn());
+  }
+
+  void walk(const Nnue::Network& net, ChessGame& game, int depth, int& nodes) {
+    ASSERT_EQ(game.evaluate(), refreshed_eval(net, game));
+    nodes++;
+    if (depth == 0) {
+      return;
+    }
+    MoveList moves;
+    game.generate_legal_moves(moves);
+    for (const PackedMove m : moves) {
+      game.apply_move(m);
+      walk(net, game, depth - 1, nodes);
+      game.undo_move();
+    }
+  }
+}
+
+// Each test writes its networks under its own names in the temp directory and removes them
+class NnueTest : public ::testing::Test {
+protected:
+  std::string temp_path(const std::string& suffix) {
+    const std::string name = std::string("test_nnue_") + testing::UnitTest::GetInstance()->current_test_info()->name()
+                           + suffix;
+    paths.push_back((std::filesystem::temp_directory_path() / name).string());
+    return paths.back();
+  }
+
+  std::string network(uint32_t version = Nnue::file_version) {
+    return write_network(temp_path(".bin"), version);
+  }
+
+  void TearDown() override {
+    for (const auto& path : paths) {
+      std::filesystem::remove(path);
+    }
+  }
+
+  std::vector<std::string> paths;
+};
+
+TEST_F(NnueTest, IncrementalAccumulatorsMatchRefresh) {
+  Nnue::Network net(network());
+  for (const auto simd : supported_simd()) {
+    net.set_simd(simd);
+    // Castling both ways, en passant and promotions with and without capture
+    for (const std::string fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                                  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+                                  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"}) {
+      ChessGame game(fen);
+      game.set_network(&net);
+      const int before = game.evaluate();
+      int nodes = 0;
+      walk(net, game, 3, nodes);
+      EXPECT_GT(nodes, 1000) << fen;
+      EXPECT_EQ(game.evaluate(), before) << fen;
+    }
+  }
+}
+
+TEST_F(NnueTest, KernelsAgree) {
+  Nnue::Network net(network());
+  const ChessGame game("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10");
+  net.set_simd(Nnue::Simd::Scalar);
+  const int expected = refreshed_eval(net, game);
+  for (const auto simd : supported_simd()) {
+    net.set_simd(simd);
+    EXPECT_EQ(refreshed_eval(net, game), expected) << static_cast<int>(simd);
+  }
+}
+
+TEST_F(NnueTest, ClassicalEvaluationWithoutNetwork) {
+  const Nnue::Network net(network());
+  ChessGame game("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10");
+  EXPECT_EQ(game.evaluate(), game.get_board().evaluate(White));
+  game.set_network(&net);
+  EXPECT_EQ(game.evaluate(), refreshed_eval(net, game));
+  game.set_network(nullptr);
+  EXPECT_EQ(game.evaluate(), game.get_board().evaluate(White));
+}
+
+TEST_F(NnueTest, UndoPastSetNetwork) {
+  const Nnue::Network net(network());
+  ChessGame game("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+  for (int ply = 0; ply < 4; ply++) {
+    MoveList moves;
+    game.generate_legal_moves(moves);
+    game.apply_move(moves[ply]);
+  }
+  game.set_network(&net);
+  MoveList moves;
+  game.generate_legal_moves(moves);
+  game.apply_move(moves[0]);
+  for (int ply = 0; ply < 5; ply++) {
+    game.undo_move();
+    ASSERT_EQ(game.evaluate(), refreshed_eval(net, game)) << ply;
+  }
+  int nodes = 0;
+  walk(net, game, 2, nodes);
+}
+
+TEST_F(NnueTest, RejectsMismatchedFiles) {
+  EXPECT_THROW(Nnue::Network{"/nonexistent/network.bin"}, std::runtime_error);
+  EXPECT_THROW(Nnue::Network{network(Nnue::file_version + 1)}, std::runtime_error);
+  const auto truncated = temp_path("_short.bin");
+  std::ofstream(truncated, std::ios::binary).write("NNUE", 4);
+  EXPECT_THROW(Nnue::Network{truncated}, std::runtime_error);
+}
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include <GameTypes.h>
+
+TEST(PackedMoveTest, FitsInSixteenBits) {
+  static_assert(sizeof(PackedMove) == 2);
+  EXPECT_FALSE(PackedMove{});
+}
+
+TEST(PackedMoveTest, AccessorsDecodeFields) {
+  const PackedMove m{to_index({Rank_7, File_B}), to_index({Rank_8, File_C}), MoveFlag::QueenPromotionCapture};
+  EXPECT_EQ(m.from(), to_index({Rank_7, File_B}));
+  EXPECT_EQ(m.to(), to_index({Rank_8, File_C}));
+  EXPECT_TRUE(m.is_capture());
+  EXPECT_TRUE(m.is_promotion());
+  EXPECT_FALSE(m.is_castling());
+  EXPECT_EQ(m.promotion_piece(), Queen);
+  EXPECT_EQ(m.to_string(), "b7c8q");
+  EXPECT_EQ(PackedMove::from_raw(m.raw()), m);
+}
+
+TEST(PackedMoveTest, RoundTripsThroughMove) {
+  Move promotion{{Rank_2, File_H}, {Rank_1, File_H}};
+  promotion.needs_pawn_promotion = true;
+  promotion.promote_to = Knight;
+  Move en_passant{{Rank_5, File_E}, {Rank_6, File_D}};
+  en_passant.is_en_passant = true;
+  Move castle{{Rank_1, File_E}, {Rank_1, File_C}};
+  castle.is_q_castle = true;
+
+  for (const Move& m : {promotion, en_passant, castle, Move{{Rank_1, File_G}, {Rank_3, File_F}}}) {
+    const Move back = PackedMove(m, false).to_move();
+    EXPECT_EQ(to_index(back.from), to_index(m.from));
+    EXPECT_EQ(to_index(back.to), to_index(m.to));
+    EXPECT_EQ(back.is_en_passant, m.is_en_passant);
+    EXPECT_EQ(back.is_k_castle, m.is_k_castle);
+    EXPECT_EQ(back.is_q_castle, m.is_q_castle);
+    EXPECT_EQ(back.needs_pawn_promotion, m.needs_pawn_promotion);
+    EXPECT_EQ(back.promote_to, m.promote_to);
+  }
+  EXPECT_EQ(PackedMove(promotion, false).flag(), MoveFlag::KnightPromotion);
+  EXPECT_EQ(PackedMove(promotion, true).flag(), MoveFlag::KnightPromotionCapture);
+  EXPECT_TRUE(PackedMove(en_passant, false).is_capture());
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <ChessGame.h>
+#include <PawnTable.h>
+#include <bit>
+
+namespace {
+  uint64_t recompute_pawn_key(const GameBoard& board) {
+    uint64_t key = 0;
+    for (const Color c : {White, Black}) {
+      Bitboard pawns = board.pieces(c, Pawn);
+      while (pawns) {
+        key ^= Zobrist::keys.piece_square[GameBoard::piece_index({Pawn, c})][pop_lsb(pawns)];
+      }
+    }
+    return key;
+  }
+
+  void walk(ChessGame& game, const PositionSnapshot& snapshot, int depth, int& pawn_changes) {
+    const uint64_t key = game.get_board().pawn_key();
+    ASSERT_EQ(key, recompute_pawn_key(game.get_board()));
+    ASSERT_EQ(snapshot.pawn_key(), key);
+    if (depth == 0) {
+      return;
+    }
+    MoveList moves;
+    game.generate_legal_moves(moves);
+    for (const PackedMove m : moves) {
+      const bool pawns_change = game.get_board().at(to_square(m.from())).type == Pawn
+                             || game.get_board().at(to_square(m.to())).type == Pawn || m.is_en_passant();
+      game.apply_move(m);
+      ASSERT_EQ(game.get_board().pawn_key() != key, pawns_change) << m.to_string();
+      pawn_changes += pawns_change;
+      walk(game, snapshot.make_move(m), depth - 1, pawn_changes);
+      game.undo_move();
+    }
+  }
+
+  Bitboard bb(std::initializer_list<const char*> squares) {
+    Bitboard b = 0;
+    for (const char* s : squares) {
+      b |= square_bb((s[1] - '1') * 8 + (s[0] - 'a'));
+    }
+    return b;
+  }
+}
+
+TEST(PawnTableTest, PawnKeyFollowsPawnMovesOnly) {
+  for (const std::string fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                                "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                                "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"}) {
+    ChessGame game(fen);
+    int pawn_changes = 0;
+    walk(game, game.snapshot(), 3, pawn_changes);
+    EXPECT_GT(pawn_changes, 100) << fen;
+  }
+}
+
+TEST(PawnTableTest, StructureTerms) {
+  // White: doubled isolated c-pawns, an isolated e-pawn and a passed a-pawn.
+  // Black: d6 cannot advance past e4 and no pawn on the c or e file is level with or behind it.
+  const PawnEntry e = evaluate_pawns(bb({"c2", "c3", "e4", "a5"}), bb({"c5", "d6"}));
+  EXPECT_EQ(e.passed[0], bb({"a5"}));
+  EXPECT_EQ(e.passed[1], 0u);
+  EXPECT_TRUE(e.attack_span[0] & bb({"d6", "f6", "b8"}));
+  EXPECT_FALSE(e.attack_span[0] & bb({"a8", "e6"}));
+  EXPECT_LT(evaluate_pawns(bb({"c2", "c3"}), 0).score.eg, evaluate_pawns(bb({"c2", "d3"}), 0).score.eg);
+
+  // With c7 behind it the d-pawn is no longer backward
+  const PawnEntry supported = evaluate_pawns(bb({"c2", "c3", "e4", "a5"}), bb({"c7", "d6"}));
+  EXPECT_EQ(e.score.mg - supported.score.mg, 8);
+  EXPECT_EQ(e.score.eg - supported.score.eg, 10);
+
+  const PawnEntry none = evaluate_pawns(0, 0);
+  EXPECT_EQ(none.score, Eval::Score{});
+}
+
+TEST(PawnTableTest, MirroredStructureIsNegated) {
+  const Bitboard white = bb({"a2", "b3", "c2", "c4", "e5", "g2", "h2"});
+  const Bitboard black = bb({"a7", "b7", "d6", "f7", "g6", "h5"});
+  const PawnEntry e = evaluate_pawns(white, black);
+  const PawnEntry m = evaluate_pawns(std::byteswap(black), std::byteswap(white));
+  EXPECT_EQ(m.score, -e.score);
+  EXPECT_EQ(m.passed[0], std::byteswap(e.passed[1]));
+  EXPECT_EQ(m.attack_span[1], std::byteswap(e.attack_span[0]));
+}
+
+TEST(PawnTableTest, CachesByKeyAndCountsHits) {
+  PawnTable table(1000);
+  EXPECT_EQ(table.size(), 512u);
+  const ChessGame game("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10");
+  const GameBoard& board = game.get_board();
+  const PawnEntry expected = evaluate_pawns(board.pieces(White, Pawn), board.pieces(Black, Pawn));
+  for (int i = 0; i < 4; ++i) {
+    const PawnEntry& e = table.probe(board.pawn_key(), board.pieces(White, Pawn), board.pieces(Black, Pawn));
+    EXPECT_EQ(e.score, expected.score);
+    EXPECT_EQ(e.passed, expected.passed);
+  }
+  EXPECT_EQ(table.stats().probes, 4u);
+  EXPECT_EQ(table.stats().hits, 3u);
+  EXPECT_DOUBLE_EQ(table.stats().hit_rate(), 0.75);
+  table.clear();
+  EXPECT_EQ(table.stats().probes, 0u);
+}
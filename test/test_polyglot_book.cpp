@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include <ChessGame.h>
+#include <PolyglotBook.h>
+#include <Uci.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace {
+  struct Entry {
+    uint64_t key;
+    uint16_t move;
+    uint16_t weight;
+  };
+
+  uint16_t encode(const std::string& uci) {
+    const uint16_t from = static_cast<uint16_t>((uci[0] - 'a') | (uci[1] - '1') << 3);
+    const uint16_t to = static_cast<uint16_t>((uci[2] - 'a') | (uci[3] - '1') << 3);
+    uint16_t promotion = 0;
+    if (uci.size() == 5) {
+      promotion = static_cast<uint16_t>(std::string_view("nbrq").find(uci[4]) + 1);
+    }
+    return static_cast<uint16_t>(to | from << 6 | promotion << 12);
+  }
+
+  void put_big_endian(std::ofstream& out, uint64_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; --i) {
+      out.put(static_cast<char>(value >> (8 * i) & 0xFF));
+    }
+  }
+
+  std::string write_book(const std::string& path, std::vector<Entry> entries) {
+    std::ranges::stable_sort(entries, {}, &Entry::key);
+    std::ofstream out(path, std::ios::binary);
+    for (const Entry& e : entries) {
+      put_big_endian(out, e.key, 8);
+      put_big_endian(out, e.move, 2);
+      put_big_endian(out, e.weight, 2);
+      put_big_endian(out, 0, 4);
+    }
+    return path;
+  }
+
+  std::string uci(const Move& m) {
+    return PackedMove(m, false).to_string();
+  }
+}
+
+// ctest runs tests in parallel processes, so each one names its books after its process id and removes them
+class PolyglotBookTest : public ::testing::Test {
+protected:
+  std::string temp_path(const std::string& name) {
+    const std::string file = name + "_" + std::to_string(getpid()) + ".bin";
+    paths.push_back((std::filesystem::temp_directory_path() / file).string());
+    return paths.back();
+  }
+
+  std::string book_file(const std::string& name, std::vector<Entry> entries) {
+    return write_book(temp_path(name), std::move(entries));
+  }
+
+  void TearDown() override {
+    for (const auto& path : paths) {
+      std::filesystem::remove(path);
+    }
+  }
+
+  std::vector<std::string> paths;
+};
+
+// The examples from the Polyglot book format description
+TEST_F(PolyglotBookTest, KeysMatchTheReferenceValues) {
+  const std::vector<std::pair<std::string, uint64_t>> cases = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0x463B96181691FC9CULL},
+    {"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", 0x823C9B50FD114196ULL},
+    {"rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756B94461C50FB0ULL},
+    {"rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", 0x662FAFB965DB29D4ULL},
+    // The en passant file counts once the e5 pawn can take on f6
+    {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0x22A48B5A8E47FF78ULL},
+    {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", 0x652A607CA3F242C1ULL},
+    {"rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", 0x00FDD303C946BDD9ULL},
+    {"rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", 0x3C8123EA7B067637ULL},
+    {"rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", 0x5C3F9B829B279560ULL},
+  };
+  for (const auto& [fen, expected] : cases) {
+    EXPECT_EQ(Polyglot::key(ChessGame(fen)), expected) << fen;
+  }
+  EXPECT_EQ(Polyglot::key(ChessGame()), Polyglot::start_position_key);
+
+  // The same keys follow the game move by move
+  ChessGame game;
+  game.apply_move(Move{{Rank_2, File_E}, {Rank_4, File_E}});
+  EXPECT_EQ(Polyglot::key(game), 0x823C9B50FD114196ULL);
+  game.apply_move(Move{{Rank_7, File_D}, {Rank_5, File_D}});
+  EXPECT_EQ(Polyglot::key(game), 0x0756B94461C50FB0ULL);
+  game.apply_move(Move{{Rank_4, File_E}, {Rank_5, File_E}});
+  game.apply_move(Move{{Rank_7, File_F}, {Rank_5, File_F}});
+  EXPECT_EQ(Polyglot::key(game), 0x22A48B5A8E47FF78ULL);
+}
+
+TEST_F(PolyglotBookTest, LooksUpAndDecodesMoves) {
+  const ChessGame start;
+  const ChessGame castling("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+  const ChessGame promotion("8/P7/8/8/8/8/8/k6K w - - 0 1");
+  const std::string path = book_file("polyglot_book", {
+    {Polyglot::key(start), encode("e2e4"), 10},
+    {Polyglot::key(start), encode("d2d4"), 30},
+    {Polyglot::key(start), encode("e2e5"), 50},
+    {Polyglot::key(castling), encode("e1h1"), 1},
+    {Polyglot::key(castling), encode("e1a1"), 1},
+    {Polyglot::key(promotion), encode("a7a8q"), 1},
+    {1, encode("a2a3"), 1},
+    {~0ULL, encode("a2a3"), 1},
+  });
+  const Polyglot::Book book(path);
+  EXPECT_EQ(book.size(), 8u);
+
+  // The illegal e2e5 is dropped
+  const auto opening = book.moves(start);
+  ASSERT_EQ(opening.size(), 2u);
+  EXPECT_EQ(uci(opening[0].move) + uci(opening[1].move), "e2e4d2d4");
+
+  const auto castles = book.moves(castling);
+  ASSERT_EQ(castles.size(), 2u);
+  EXPECT_EQ(uci(castles[0].move), "e1g1");
+  EXPECT_TRUE(castles[0].move.is_k_castle);
+  EXPECT_EQ(uci(castles[1].move), "e1c1");
+  EXPECT_TRUE(castles[1].move.is_q_castle);
+
+  const auto promotions = book.moves(promotion);
+  ASSERT_EQ(promotions.size(), 1u);
+  EXPECT_TRUE(promotions[0].move.needs_pawn_promotion);
+  EXPECT_EQ(promotions[0].move.promote_to, Queen);
+
+  EXPECT_TRUE(book.moves(ChessGame("8/8/8/8/8/8/8/k6K w - - 0 1")).empty());
+}
+
+TEST_F(PolyglotBookTest, PicksByWeight) {
+  const ChessGame start;
+  const Polyglot::Book book(book_file("polyglot_weights", {
+    {Polyglot::key(start), encode("e2e4"), 1},
+    {Polyglot::key(start), encode("d2d4"), 3},
+    {Polyglot::key(start), encode("g1f3"), 0},
+  }));
+  std::mt19937_64 rng(7);
+  EXPECT_EQ(uci(*book.pick(start, Polyglot::Selection::Best, rng)), "d2d4");
+
+  int d4 = 0;
+  for (int i = 0; i < 4000; ++i) {
+    const std::string move = uci(*book.pick(start, Polyglot::Selection::Weighted, rng));
+    ASSERT_NE(move, "g1f3");
+    d4 += move == "d2d4";
+  }
+  EXPECT_NEAR(d4, 3000, 150);
+
+  EXPECT_FALSE(book.pick(ChessGame("8/8/8/8/8/8/8/k6K w - - 0 1"), Polyglot::Selection::Best, rng));
+}
+
+TEST_F(PolyglotBookTest, RejectsMalformedFiles) {
+  const auto path = temp_path("polyglot_short");
+  std::ofstream(path, std::ios::binary) << "not a book";
+  EXPECT_THROW(Polyglot::Book{path}, std::runtime_error);
+  EXPECT_THROW(Polyglot::Book{"/nonexistent/book.bin"}, std::runtime_error);
+  const Polyglot::Book empty(book_file("polyglot_empty", {}));
+  EXPECT_EQ(empty.size(), 0u);
+  EXPECT_TRUE(empty.moves(ChessGame()).empty());
+}
+
+TEST_F(PolyglotBookTest, UciAnswersFromTheBook) {
+  ChessGame after_e4;
+  after_e4.apply_move(Move{{Rank_2, File_E}, {Rank_4, File_E}});
+  const std::string book = book_file("polyglot_uci", {{Polyglot::key(after_e4), encode("c7c5"), 1}});
+
+  std::istringstream in;
+  std::ostringstream out;
+  UciEngine engine(in, out);
+  engine.execute("setoption name BookFile value " + book);
+  engine.execute("position startpos moves e2e4");
+  engine.execute("go wtime 60000 btime 60000");
+  engine.wait_for_search();
+  EXPECT_EQ(out.str(), "bestmove c7c5\n");
+
+  // Out of book the engine searches as usual
+  engine.execute("position startpos moves e2e4 c7c5");
+  engine.execute("go depth 1");
+  engine.wait_for_search();
+  EXPECT_NE(out.str().find("info depth 1"), std::string::npos);
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <ChessGame.h>
+#include <Perft.h>
+#include <PositionSnapshot.h>
+
+static uint64_t snapshot_perft(const PositionSnapshot& position, int depth) {
+  if (depth == 0) {
+    return 1;
+  }
+  MoveList moves;
+  position.generate_legal_moves(moves);
+  uint64_t nodes{};
+  for (const auto m : moves) {
+    nodes += snapshot_perft(position.make_move(m), depth - 1);
+  }
+  return nodes;
+}
+
+static void compare_walk(ChessGame& game, const PositionSnapshot& position, int depth) {
+  ASSERT_EQ(game.snapshot(), position);
+  if (depth == 0) {
+    return;
+  }
+  MoveList moves;
+  game.generate_legal_moves(moves);
+  for (const auto m : moves) {
+    const PositionSnapshot next = position.make_move(m);
+    game.apply_move(m);
+    compare_walk(game, next, depth - 1);
+    game.undo_move();
+  }
+}
+
+class PositionSnapshotTest : public ::testing::TestWithParam<std::string> {
+protected:
+  PositionSnapshotTest() = default;
+};
+
+TEST_P(PositionSnapshotTest, MakeMoveMatchesApplyMove) {
+  ChessGame game(GetParam());
+  compare_walk(game, game.snapshot(), 3);
+}
+
+TEST_P(PositionSnapshotTest, CopyMakePerftMatches) {
+  ChessGame game(GetParam());
+  EXPECT_EQ(snapshot_perft(game.snapshot(), 3), perft(game, 3));
+}
+
+TEST_P(PositionSnapshotTest, GameRoundTripsThroughSnapshot) {
+  ChessGame game(GetParam());
+  const PositionSnapshot position = game.snapshot();
+  ChessGame rebuilt(position);
+  EXPECT_EQ(rebuilt.key(), game.key());
+  EXPECT_EQ(rebuilt.snapshot(), position);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  StandardPositions,
+  PositionSnapshotTest,
+  ::testing::Values(
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3"
+    ));
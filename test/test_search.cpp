@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <ParallelSearch.h>
+#include <Search.h>
+#include <future>
+#include <thread>
+
+TEST(SearchTest, FindsBackRankMate) {
+  ChessGame game("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+  Search search(game);
+  SearchLimits limits;
+  limits.depth = 3;
+  const SearchResult result = search.run(limits);
+  EXPECT_EQ(result.best_move.to_string(), "a1a8");
+  EXPECT_EQ(result.score, Search::mate_score - 1);
+  EXPECT_TRUE(Search::is_mate_score(result.score));
+}
+
+TEST(SearchTest, FindsMateInTwo) {
+  // 1. Qd8+ Rxd8 2. Rxd8#
+  ChessGame game("2r3k1/5ppp/8/8/8/8/3Q1PPP/3R2K1 w - - 0 1");
+  Search search(game);
+  SearchLimits limits;
+  limits.depth = 5;
+  const SearchResult result = search.run(limits);
+  EXPECT_EQ(result.best_move.to_string(), "d2d8");
+  EXPECT_EQ(result.score, Search::mate_score - 3);
+  ASSERT_GE(result.pv.size(), 3u);
+  EXPECT_EQ(result.pv[2].to_string(), "d1d8");
+}
+
+TEST(SearchTest, WinsHangingQueen) {
+  ChessGame game("4k3/8/8/3q4/8/8/8/3QK3 w - - 0 1");
+  Search search(game);
+  SearchLimits limits;
+  limits.depth = 3;
+  const SearchResult result = search.run(limits);
+  EXPECT_EQ(result.best_move.to_string(), "d1d5");
+  EXPECT_GE(result.score, 800);
+}
+
+TEST(SearchTest, StalemateAndMateHaveNoMove) {
+  ChessGame stalemate("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1");
+  const SearchResult drawn = Search(stalemate).run({});
+  EXPECT_FALSE(drawn.best_move);
+  EXPECT_EQ(drawn.score, 0);
+
+  ChessGame mated("R5k1/5ppp/8/8/8/8/8/6K1 b - - 0 1");
+  const SearchResult lost = Search(mated).run({});
+  EXPECT_FALSE(lost.best_move);
+  EXPECT_EQ(lost.score, -Search::mate_score);
+}
+
+TEST(SearchTest, RespectsNodeLimit) {
+  ChessGame game;
+  Search search(game);
+  SearchLimits limits;
+  limits.nodes = 5000;
+  const SearchResult result = search.run(limits);
+  EXPECT_LE(result.nodes, limits.nodes);
+  EXPECT_GE(result.depth, 1);
+  EXPECT_TRUE(result.best_move);
+}
+
+TEST(SearchTest, RespectsMoveTime) {
+  ChessGame game;
+  Search search(game);
+  SearchLimits limits;
+  limits.move_time = std::chrono::milliseconds(50);
+  limits.depth = 40;
+  // The move time ends the search long before the depth cap, however loaded the machine
+  const SearchResult result = search.run(limits);
+  EXPECT_LT(result.depth, limits.depth);
+  EXPECT_TRUE(result.best_move);
+}
+
+TEST(SearchTest, StopBeforeRunIsNotLost) {
+  ChessGame game;
+  Search search(game);
+  SearchLimits limits;
+  limits.depth = 6;
+  search.stop();
+  const SearchResult stopped = search.run(limits);
+  EXPECT_EQ(stopped.depth, 0);
+  EXPECT_TRUE(stopped.best_move);
+  // The request was used up by that run
+  limits.depth = 2;
+  EXPECT_EQ(search.run(limits).depth, 2);
+}
+
+TEST(SearchTest, ReportsEachIterationAndLeavesGameUntouched) {
+  ChessGame game;
+  const uint64_t key = game.key();
+  Search search(game);
+  SearchLimits limits;
+  limits.depth = 4;
+  std::vector<int> depths;
+  const SearchResult result = search.run(limits, [&](const SearchResult& r) {
+    depths.push_back(r.depth);
+    EXPECT_FALSE(r.pv.empty());
+    EXPECT_EQ(r.pv.front(), r.best_move);
+  });
+  EXPECT_EQ(depths, (std::vector<int>{1, 2, 3, 4}));
+  EXPECT_EQ(result.depth, 4);
+  EXPECT_EQ(game.key(), key);
+}
+
+TEST(ParallelSearchTest, HelpersShareTableAndMainResultIsKept) {
+  TranspositionTable tt(16);
+  ParallelSearch search(tt, 4);
+  EXPECT_EQ(search.threads(), 4u);
+
+  ChessGame game("2r3k1/5ppp/8/8/8/8/3Q1PPP/3R2K1 w - - 0 1");
+  SearchLimits limits;
+  limits.depth = 5;
+  const SearchResult result = search.run(game, limits);
+  EXPECT_EQ(result.best_move.to_string(), "d2d8");
+  EXPECT_EQ(result.score, Search::mate_score - 3);
+  EXPECT_GT(search.tt_stats().stores, 0u);
+}
+
+TEST(ParallelSearchTest, StopsFromAnotherThread) {
+  TranspositionTable tt(16);
+  ParallelSearch search(tt, 3);
+  ChessGame game;
+  SearchResult result;
+  std::promise<void> first_iteration;
+  bool iterated = false;
+  std::thread worker([&] {
+    result = search.run(game, {}, [&](const SearchResult&) {
+      if (!iterated) {
+        iterated = true;
+        first_iteration.set_value();
+      }
+    });
+  });
+  first_iteration.get_future().wait();
+  search.stop();
+  worker.join();
+  EXPECT_TRUE(result.best_move);
+  EXPECT_GE(result.depth, 1);
+
+  search.set_threads(1);
+  SearchLimits limits;
+  limits.depth = 3;
+  EXPECT_EQ(search.run(game, limits).depth, 3);
+}
+
+TEST(ParallelSearchTest, StopBeforeRunIsNotLost) {
+  TranspositionTable tt(16);
+  ParallelSearch search(tt, 3);
+  ChessGame game;
+  SearchLimits limits;
+  limits.depth = 8;
+  search.stop();
+  EXPECT_EQ(search.run(game, limits).depth, 0);
+  limits.depth = 2;
+  EXPECT_EQ(search.run(game, limits).depth, 2);
+}
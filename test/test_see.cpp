@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <ChessGame.h>
+
+static PackedMove find_move(ChessGame& game, const std::string& uci) {
+  MoveList moves;
+  game.generate_legal_moves(moves);
+  for (const auto m : moves) {
+    if (m.to_string() == uci) {
+      return m;
+    }
+  }
+  ADD_FAILURE() << "no legal move " << uci;
+  return {};
+}
+
+struct SeeCase {
+  std::string fen;
+  std::string move;
+  int value;
+};
+
+class SeeTest : public ::testing::TestWithParam<SeeCase> {};
+
+TEST_P(SeeTest, MatchesHandCountedExchange) {
+  const auto& [fen, uci, value] = GetParam();
+  ChessGame game(fen);
+  const PackedMove m = find_move(game, uci);
+  EXPECT_EQ(game.see(m), value);
+  EXPECT_TRUE(game.see_ge(m, value));
+  EXPECT_FALSE(game.see_ge(m, value + 1));
+  EXPECT_EQ(game.snapshot().see(m), value);
+}
+
+INSTANTIATE_TEST_SUITE_P(Exchanges, SeeTest, ::testing::Values(
+  // Undefended pawn
+  SeeCase{"1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5", 100},
+  // Knight takes a pawn defended by a pawn
+  SeeCase{"4k3/8/3p4/4p3/8/5N2/8/4K3 w - - 0 1", "f3e5", 100 - 320},
+  // The rook behind joins as an x-ray and wins the pawn
+  SeeCase{"4k3/4r3/8/4p3/8/8/4R3/4R1K1 w - - 0 1", "e2e5", 100},
+  // Without the x-ray the rook is lost for a pawn
+  SeeCase{"4k3/4r3/8/4p3/8/8/4R3/6K1 w - - 0 1", "e2e5", 100 - 500},
+  // The king recaptures an undefended attacker
+  SeeCase{"1k6/p7/8/8/8/8/8/R3K3 w - - 0 1", "a1a7", 100 - 500},
+  // but not one still covered by the bishop
+  SeeCase{"1k6/p7/8/8/8/8/8/R3K1B1 w - - 0 1", "a1a7", 100},
+  // Promotion onto an unguarded square
+  SeeCase{"8/1P6/8/8/8/8/8/k5K1 w - - 0 1", "b7b8q", 900 - 100},
+  // En passant
+  SeeCase{"4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6", 100},
+  // Quiet move onto a square the pawn attacks
+  SeeCase{"4k3/8/3p4/8/8/8/8/2B1K3 w - - 0 1", "c1g5", 0},
+  SeeCase{"4k3/8/5p2/8/8/8/8/2B1K3 w - - 0 1", "c1g5", -330}
+));
+
+static void check_consistency(ChessGame& game, int depth, int& captures) {
+  MoveList moves;
+  game.generate_legal_moves(moves);
+  for (const PackedMove m : moves) {
+    if (m.is_capture()) {
+      captures++;
+      const int value = game.see(m);
+      for (const int threshold : {value - 1, value, value + 1, 0, -100, 100}) {
+        ASSERT_EQ(game.see_ge(m, threshold), value >= threshold) << m.to_string() << " " << threshold;
+      }
+    }
+    if (depth > 1) {
+      game.apply_move(m);
+      check_consistency(game, depth - 1, captures);
+      game.undo_move();
+    }
+  }
+}
+
+TEST(SeeConsistencyTest, SeeGeAgreesWithSee) {
+  for (const std::string fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                                "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"}) {
+    ChessGame game(fen);
+    int captures = 0;
+    check_consistency(game, 3, captures);
+    EXPECT_GT(captures, 1000) << fen;
+  }
+}
@@ -0,0 +1,451 @@
+#include <gtest/gtest.h>
+#include <ChessGame.h>
+#include <Kpk.h>
+#include <Search.h>
+#include <Tablebase.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+  using Tablebase::Wdl;
+
+  // ctest runs every test in its own process, several at once, so each process gets its own directories
+  std::string temp_directory(const std::string& name) {
+    const auto path = std::filesystem::temp_directory_path() / (name + "_" + std::to_string(getpid()));
+    std::filesystem::remove_all(path);
+    std::filesystem::create_directories(path);
+    return path.string();
+  }
+
+  std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+  }
+
+  PositionSnapshot position(int white_king, int black_king, Piece extra, int extra_sq, Color side_to_move) {
+    const std::array<std::pair<Piece, int>, 3> pieces{{{{King, White}, white_king}, {{King, Black}, black_king},
+                                                       {extra, extra_sq}}};
+    return PositionSnapshot(pieces, side_to_move);
+  }
+
+  bool legal(const PositionSnapshot& p) {
+    const Color them = p.side_to_move() == White ? Black : White;
+    return !(p.attackers_to(lsb(p.pieces(them, King)), p.occupancy()) & p.pieces(p.side_to_move()));
+  }
+
+  // The same pieces and side to move without an en passant square
+  PositionSnapshot without_en_passant(const PositionSnapshot& p) {
+    std::vector<std::pair<Piece, int>> pieces;
+    for (Bitboard b = p.occupancy(); b;) {
+      const int sq = pop_lsb(b);
+      pieces.emplace_back(p.at(sq), sq);
+    }
+    return PositionSnapshot(pieces, p.side_to_move());
+  }
+
+  // Result for the side that moved into a position whose side to move has r
+  Tablebase::ProbeResult parent(Tablebase::ProbeResult r) {
+    return r.wdl == Wdl::Draw ? r : Tablebase::ProbeResult{r.wdl == Wdl::Win ? Wdl::Loss : Wdl::Win, r.plies + 1};
+  }
+
+  bool better(Tablebase::ProbeResult a, Tablebase::ProbeResult b) {
+    if (a.wdl != b.wdl) {
+      return a.wdl > b.wdl;
+    }
+    return a.wdl == Wdl::Win ? a.plies < b.plies : a.wdl == Wdl::Loss && a.plies > b.plies;
+  }
+
+  // Probes p, or with an en passant square takes the better of the table's entry and capturing en passant
+  std::optional<Tablebase::ProbeResult> value(const Tablebase::Tablebases& tables, const PositionSnapshot& p) {
+    if (!p.en_passant()) {
+      return tables.probe(p);
+    }
+    auto best = tables.probe(without_en_passant(p));
+    MoveList moves;
+    p.generate_legal_moves(moves);
+    for (const PackedMove m : moves) {
+      if (!m.is_en_passant()) {
+        continue;
+      }
+      const auto reply = tables.probe(p.make_move(m));
+      if (!best || !reply) {
+        return std::nullopt;
+      }
+      if (better(parent(*reply), *best)) {
+        best = parent(*reply);
+      }
+    }
+    return best;
+  }
+
+  // Result of p worked out from the values of the positions its moves lead to
+  std::optional<Tablebase::ProbeResult> one_ply(const Tablebase::Tablebases& tables, const PositionSnapshot& p) {
+    MoveList moves;
+    p.generate_legal_moves(moves);
+    if (moves.empty()) {
+      return Tablebase::ProbeResult{p.in_check() ? Wdl::Loss : Wdl::Draw, 0};
+    }
+    std::optional<Tablebase::ProbeResult> best;
+    for (const PackedMove m : moves) {
+      const auto reply = value(tables, p.make_move(m));
+      if (!reply) {
+        return std::nullopt;
+      }
+      if (!best || better(parent(*reply), *best)) {
+        best = parent(*reply);
+      }
+    }
+    return best;
+  }
+
+  // Plies to mate, even for the side to move being mated, or -1 for a draw
+  int table_plies(const Tablebase::Tablebases& tables, const PositionSnapshot& p) {
+    const auto result = tables.probe(p);
+    EXPECT_TRUE(result.has_value());
+    return !result || result->wdl == Wdl::Draw ? -1 : result->plies;
+  }
+
+  /**
+   * Follows the table from p until the game ends: the winner plays a move the table
+   * rates one ply shorter, the loser the longest defence. Moves that capture or promote
+   * are probed in their own tables, double pushes are left out.
+   * @return Plies actually played before mate, or -1 if some move disagrees with the table
+   */
+  int play_out(const Tablebase::Tablebases& tables, PositionSnapshot p) {
+    for (int played = 0;; ++played) {
+      const auto result = tables.probe(p);
+      MoveList moves;
+      p.generate_legal_moves(moves);
+      if (!result || result->wdl == Wdl::Draw) {
+        return -1;
+      }
+      if (moves.empty()) {
+        return p.in_check() && result->plies == 0 ? played : -1;
+      }
+      const Wdl opposite = result->wdl == Wdl::Win ? Wdl::Loss : Wdl::Win;
+      std::optional<PositionSnapshot> next;
+      for (const PackedMove m : moves) {
+        const PositionSnapshot child = p.make_move(m);
+        const auto reply = tables.probe(child);
+        // A double push leaves an en passant square, which the tables do not cover
+        if (!reply) {
+          continue;
+        }
+        if (reply->wdl != opposite || reply->plies >= result->plies) {
+          if (result->wdl == Wdl::Loss) {
+            return -1;
+          }
+          continue;
+        }
+        if (reply->plies == result->plies - 1) {
+          next = child;
+        }
+      }
+      if (!next) {
+        return -1;
+      }
+      p = *next;
+    }
+  }
+
+  class TablebaseTest : public testing::Test {
+  protected:
+    static void SetUpTestSuite() {
+      directory = temp_directory("chess_engine_tablebase_test");
+      tables = std::make_unique<Tablebase::Tablebases>();
+      for (const char* signature : {"KQvK", "KRvK", "KBvK", "KNvK", "KPvK"}) {
+        stats[signature] = Tablebase::generate(signature, directory, *tables, 1);
+      }
+    }
+
+    static void TearDownTestSuite() {
+      tables.reset();
+      std::filesystem::remove_all(directory);
+    }
+
+    static inline std::string directory;
+    static inline std::unique_ptr<Tablebase::Tablebases> tables;
+    static inline std::map<std::string, Tablebase::GenerationStats> stats;
+  };
+}
+
+TEST_F(TablebaseTest, LongestMatesMatchTheLiterature) {
+  EXPECT_EQ(stats.at("KQvK").longest_mate, 19);
+  EXPECT_EQ(stats.at("KRvK").longest_mate, 31);
+  EXPECT_EQ(stats.at("KPvK").longest_mate, 55);
+  EXPECT_EQ(stats.at("KBvK").wins, 0u);
+  EXPECT_EQ(stats.at("KNvK").wins, 0u);
+  EXPECT_EQ(tables->size(), 5u);
+  EXPECT_TRUE(tables->contains("KRvK"));
+  EXPECT_FALSE(tables->contains("KQvKR"));
+}
+
+/**
+ * Solves king and rook against king forwards, one ply per pass over every position,
+ * and compares each distance with the table, including the mirrored ones.
+ */
+TEST_F(TablebaseTest, RookEndingMatchesForwardSolution) {
+  constexpr size_t stride = 64 * 64 * 64;
+  const auto id = [](int stm, int wk, int rook, int bk) { return static_cast<size_t>(((stm * 64 + wk) * 64 + rook) * 64 + bk); };
+  constexpr int illegal = -2;
+  constexpr int unknown = -1;
+  std::vector<int> plies(2 * stride, illegal);
+  std::vector<std::vector<size_t>> children(2 * stride);
+  std::vector<bool> draw_exit(2 * stride);
+
+  for (int stm = 0; stm < 2; ++stm) {
+    for (int wk = 0; wk < 64; ++wk) {
+      for (int rook = 0; rook < 64; ++rook) {
+        for (int bk = 0; bk < 64; ++bk) {
+          if (wk == rook || wk == bk || rook == bk) {
+            continue;
+          }
+          const PositionSnapshot p = position(wk, bk, {Rook, White}, rook, stm ? Black : White);
+          if (!legal(p)) {
+            continue;
+          }
+          const size_t i = id(stm, wk, rook, bk);
+          MoveList moves;
+          p.generate_legal_moves(moves);
+          plies[i] = moves.empty() && p.in_check() ? 0 : unknown;
+          for (const PackedMove m : moves) {
+            const PositionSnapshot next = p.make_move(m);
+            if (!next.pieces(White, Rook)) {
+              draw_exit[i] = true;
+            } else {
+              children[i].push_back(id(!stm, lsb(next.pieces(White, King)), lsb(next.pieces(White, Rook)),
+                                       lsb(next.pieces(Black, King))));
+            }
+          }
+        }
+      }
+    }
+  }
+
+  for (int n = 1; n < Tablebase::max_plies; ++n) {
+    std::vector<size_t> solved;
+    for (size_t i = 0; i < plies.size(); ++i) {
+      if (plies[i] != unknown || children[i].empty()) {
+        continue;
+      }
+      if (n % 2) {
+        if (std::ranges::any_of(children[i], [&](size_t c) { return plies[c] == n - 1; })) {
+          solved.push_back(i);
+        }
+      } else if (!draw_exit[i] && std::ranges::all_of(children[i], [&](size_t c) { return plies[c] >= 0 && plies[c] % 2; })
+                 && std::ranges::any_of(children[i], [&](size_t c) { return plies[c] == n - 1; })) {
+        solved.push_back(i);
+      }
+    }
+    for (const size_t i : solved) {
+      plies[i] = n;
+    }
+  }
+
+  int longest = 0;
+  for (size_t i = 0; i < plies.size(); ++i) {
+    if (plies[i] == illegal) {
+      continue;
+    }
+    const int stm = static_cast<int>(i / stride);
+    const int wk = static_cast<int>(i / 4096 % 64);
+    const int rook = static_cast<int>(i / 64 % 64);
+    const int bk = static_cast<int>(i % 64);
+    ASSERT_EQ(table_plies(*tables, position(wk, bk, {Rook, White}, rook, stm ? Black : White)), plies[i])
+      << wk << " " << rook << " " << bk << (stm ? " b" : " w");
+    ASSERT_EQ(table_plies(*tables, position(bk ^ 56, wk ^ 56, {Rook, Black}, rook ^ 56, stm ? White : Black)), plies[i]);
+    if (plies[i] % 2) {
+      longest = std::max(longest, plies[i]);
+    }
+  }
+  EXPECT_EQ(longest, 31);
+}
+
+TEST_F(TablebaseTest, PawnEndingAgreesWithKpkBitbase) {
+  for (int stm = 0; stm < 2; ++stm) {
+    for (int wk = 0; wk < 64; ++wk) {
+      for (int pawn = 8; pawn < 56; ++pawn) {
+        for (int bk = 0; bk < 64; ++bk) {
+          if (wk == pawn || wk == bk || pawn == bk) {
+            continue;
+          }
+          const Color side = stm ? Black : White;
+          const PositionSnapshot p = position(wk, bk, {Pawn, White}, pawn, side);
+          if (!legal(p)) {
+            continue;
+          }
+          const auto result = tables->probe(p);
+          ASSERT_TRUE(result.has_value());
+          const bool win = Kpk::probe(White, wk, pawn, bk, side);
+          const Wdl expected = !win ? Wdl::Draw : side == White ? Wdl::Win : Wdl::Loss;
+          ASSERT_EQ(result->wdl, expected) << wk << " " << pawn << " " << bk << (stm ? " b" : " w");
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TablebaseTest, ProbesGamePositions) {
+  // Mate in one either way round
+  auto result = tables->probe(ChessGame("k7/8/1K6/8/8/8/8/7R w - - 0 1").snapshot());
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->wdl, Wdl::Win);
+  EXPECT_EQ(result->plies, 1);
+  result = tables->probe(ChessGame("7r/8/8/8/8/1k6/8/K7 b - - 0 1").snapshot());
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->wdl, Wdl::Win);
+  EXPECT_EQ(result->plies, 1);
+  // Mated
+  result = tables->probe(ChessGame("R1k5/8/2K5/8/8/8/8/8 b - - 0 1").snapshot());
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->wdl, Wdl::Loss);
+  EXPECT_EQ(result->plies, 0);
+  // Stalemate
+  result = tables->probe(ChessGame("8/8/8/8/8/8/1r6/K1k5 w - - 0 1").snapshot());
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->wdl, Wdl::Draw);
+
+  result = tables->probe(ChessGame("4k3/8/8/8/8/8/8/4K3 w - - 0 1").snapshot());
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->wdl, Wdl::Draw);
+  EXPECT_FALSE(tables->probe(ChessGame("4k3/8/8/8/8/8/8/R3K3 w Q - 0 1").snapshot()).has_value());
+  EXPECT_FALSE(tables->probe(ChessGame("4k3/8/8/8/8/8/8/RR2K3 w - - 0 1").snapshot()).has_value());
+  EXPECT_FALSE(tables->probe(ChessGame().snapshot()).has_value());
+}
+
+TEST_F(TablebaseTest, ThreadCountDoesNotChangeTheTable) {
+  const std::string other = temp_directory("chess_engine_tablebase_threads");
+  Tablebase::Tablebases tables_other;
+  tables_other.load_directory(directory);
+  Tablebase::generate("KRvK", other, tables_other, 3);
+  Tablebase::generate("KPvK", other, tables_other, 3);
+  EXPECT_EQ(read_file(other + "/KRvK.dtm"), read_file(directory + "/KRvK.dtm"));
+  EXPECT_EQ(read_file(other + "/KPvK.dtm"), read_file(directory + "/KPvK.dtm"));
+  std::filesystem::remove_all(other);
+}
+
+TEST_F(TablebaseTest, ReportsErrors) {
+  const std::string other = temp_directory("chess_engine_tablebase_errors");
+  Tablebase::Tablebases empty;
+  EXPECT_THROW(Tablebase::generate("KvK", other, empty, 1), std::runtime_error);
+  EXPECT_THROW(Tablebase::generate("KRvKQ", other, empty, 1), std::runtime_error);
+  EXPECT_THROW(Tablebase::generate("KXvK", other, empty, 1), std::runtime_error);
+  EXPECT_THROW(Tablebase::generate("KQRvKR", other, empty, 1), std::runtime_error);
+  // Captures of the rook lead to KQvK
+  EXPECT_THROW(Tablebase::generate("KQvKR", other, empty, 1), std::runtime_error);
+
+  std::ofstream(other + "/bogus.dtm") << "not a table";
+  EXPECT_THROW(empty.add(other + "/bogus.dtm"), std::runtime_error);
+  EXPECT_THROW(empty.load_directory(other), std::runtime_error);
+  EXPECT_THROW(empty.add(other + "/missing.dtm"), std::runtime_error);
+  EXPECT_EQ(empty.size(), 0u);
+  std::filesystem::remove_all(other);
+}
+
+TEST_F(TablebaseTest, SearchScoresTablebaseMates) {
+  SearchLimits limits;
+  limits.depth = 2;
+  Search search(ChessGame("8/8/8/3k4/8/8/8/R3K3 w - - 0 1"));
+  search.set_tablebases(tables.get());
+  const SearchResult result = search.run(limits);
+  EXPECT_TRUE(Search::is_mate_score(result.score));
+  EXPECT_GT(result.score, 0);
+  // Mate in 16 at most, and the table's line is no longer than the root's distance
+  EXPECT_GE(result.score, Search::mate_score - 31);
+  const auto root = tables->probe(ChessGame("8/8/8/3k4/8/8/8/R3K3 w - - 0 1").snapshot());
+  ASSERT_TRUE(root.has_value());
+  EXPECT_EQ(result.score, Search::mate_score - root->plies);
+}
+
+/**
+ * Generates every table with one piece a side, which the promotions of king and pawn
+ * against king and pawn lead to, and king, bishop and knight against king. One test,
+ * since each test runs in its own process and the tables take a few minutes on one core.
+ * Slow suites are only registered with CHESS_SLOW_TESTS, see test/CMakeLists.txt.
+ */
+TEST(SlowTablebaseTest, FourPieceTablesMatchTheLiterature) {
+  const std::string directory = temp_directory("chess_engine_tablebase_four_pieces");
+  Tablebase::Tablebases tables;
+  std::map<std::string, Tablebase::GenerationStats> stats;
+  const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  for (const std::string& signature : Tablebase::all_signatures()) {
+    if (signature.find('v') == 2 || signature == "KBNvK") {
+      stats[signature] = Tablebase::generate(signature, directory, tables, threads);
+    }
+  }
+  ASSERT_TRUE(tables.contains("KPvKP"));
+
+  EXPECT_EQ(stats.at("KQvKR").longest_mate, 69);
+  EXPECT_EQ(stats.at("KBNvK").longest_mate, 65);
+  EXPECT_EQ(stats.at("KRvKN").longest_mate, 79);
+  EXPECT_EQ(stats.at("KQvKP").longest_mate, 57);
+  EXPECT_EQ(stats.at("KRvKP").longest_mate, 85);
+  EXPECT_EQ(stats.at("KPvKP").longest_mate, 65);
+  EXPECT_EQ(stats.at("KNvKN").longest_mate, 1);
+
+  // Mates in one, checked against a search without tables
+  for (const char* fen : {"3k4/8/3K4/8/8/8/7r/Q7 w - - 0 1", "7k/8/5K1N/8/8/8/8/B7 w - - 0 1",
+                          "k7/2P5/K7/8/8/8/7p/8 w - - 0 1"}) {
+    const auto result = tables.probe(ChessGame(fen).snapshot());
+    ASSERT_TRUE(result.has_value()) << fen;
+    EXPECT_EQ(result->wdl, Wdl::Win) << fen;
+    EXPECT_EQ(result->plies, 1) << fen;
+    SearchLimits limits;
+    limits.depth = 2;
+    Search search{ChessGame(fen)};
+    EXPECT_EQ(search.run(limits).score, Search::mate_score - 1) << fen;
+  }
+
+  // Longer wins end in mate on the ply the table gives
+  for (const char* fen : {"6k1/8/5K2/4N3/8/8/8/B7 w - - 0 1", "8/7p/1P6/8/8/8/k7/4K3 w - - 0 1",
+                          "8/8/8/3k4/8/8/1r6/Q3K3 b - - 0 1"}) {
+    const PositionSnapshot p = ChessGame(fen).snapshot();
+    const auto result = tables.probe(p);
+    ASSERT_TRUE(result.has_value()) << fen;
+    EXPECT_NE(result->wdl, Wdl::Draw) << fen;
+    EXPECT_EQ(play_out(tables, p), result->plies) << fen;
+  }
+  EXPECT_EQ(table_plies(tables, ChessGame("6k1/8/5K2/4N3/8/8/8/B7 w - - 0 1").snapshot()), 17);
+
+  // The tables assume no en passant capture is available, so a position offering one is not covered
+  EXPECT_FALSE(tables.probe(ChessGame("k7/8/8/1Pp5/8/8/8/K7 w - c6 0 1").snapshot()).has_value());
+  EXPECT_EQ(table_plies(tables, ChessGame("k7/8/8/1Pp5/8/8/8/K7 w - - 0 1").snapshot()), -1);
+  // b2-b4 is met by axb3 e.p., so the push does not win
+  EXPECT_EQ(table_plies(tables, ChessGame("8/8/8/8/p7/K7/1P6/k7 w - - 0 1").snapshot()), -1);
+
+  // Every king and pawn against king and pawn entry follows from the entries its moves lead to
+  for (int stm = 0; stm < 2; ++stm) {
+    for (int wk = 0; wk < 64; ++wk) {
+      if ((wk & 7) > File_D) {
+        continue;
+      }
+      for (int wp = 8; wp < 56; ++wp) {
+        for (int bk = 0; bk < 64; ++bk) {
+          for (int bp = 8; bp < 56; ++bp) {
+            if (wk == wp || wk == bk || wk == bp || wp == bk || wp == bp || bk == bp) {
+              continue;
+            }
+            const std::array<std::pair<Piece, int>, 4> pieces{{{{King, White}, wk}, {{King, Black}, bk},
+                                                               {{Pawn, White}, wp}, {{Pawn, Black}, bp}}};
+            const PositionSnapshot p(pieces, stm ? Black : White);
+            if (!legal(p)) {
+              continue;
+            }
+            const auto stored = tables.probe(p);
+            const auto expected = one_ply(tables, p);
+            ASSERT_TRUE(stored && expected);
+            ASSERT_TRUE(stored->wdl == expected->wdl && stored->plies == expected->plies)
+              << wk << " " << wp << " " << bk << " " << bp << (stm ? " b" : " w");
+          }
+        }
+      }
+    }
+  }
+  std::filesystem::remove_all(directory);
+}
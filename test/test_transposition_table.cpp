@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <Search.h>
+#include <TranspositionTable.h>
+#include <thread>
+
+TEST(TranspositionTableTest, StoresAndProbes) {
+  TranspositionTable tt(1);
+  const PackedMove move(12, 28, MoveFlag::Quiet);
+  tt.store(0x1234567890ABCDEFULL, move, -31000, 7, Bound::Lower);
+
+  TTEntry entry;
+  ASSERT_TRUE(tt.probe(0x1234567890ABCDEFULL, entry));
+  EXPECT_EQ(entry.move, move);
+  EXPECT_EQ(entry.score, -31000);
+  EXPECT_EQ(entry.depth, 7);
+  EXPECT_EQ(entry.bound, Bound::Lower);
+  EXPECT_FALSE(tt.probe(0x1234567890ABCDEEULL, entry));
+
+  tt.clear();
+  EXPECT_FALSE(tt.probe(0x1234567890ABCDEFULL, entry));
+}
+
+TEST(TranspositionTableTest, KeepsDeeperResultAndMove) {
+  TranspositionTable tt(1);
+  const uint64_t key = 42;
+  const PackedMove move(1, 18, MoveFlag::Quiet);
+  tt.store(key, move, 10, 8, Bound::Lower);
+  tt.store(key, PackedMove{}, 20, 3, Bound::Upper);
+
+  TTEntry entry;
+  ASSERT_TRUE(tt.probe(key, entry));
+  EXPECT_EQ(entry.depth, 8);
+  EXPECT_EQ(entry.score, 10);
+
+  tt.store(key, PackedMove{}, 30, 9, Bound::Exact);
+  ASSERT_TRUE(tt.probe(key, entry));
+  EXPECT_EQ(entry.depth, 9);
+  EXPECT_EQ(entry.move, move);
+}
+
+TEST(TranspositionTableTest, CountsHitsCollisionsAndOverwrites) {
+  TranspositionTable tt(1);
+  const uint64_t stride = tt.entry_count() / TranspositionTable::bucket_size;
+  TTStats stats;
+  // Five keys sharing a bucket of four, the shallowest is evicted
+  for (uint64_t i = 0; i <= TranspositionTable::bucket_size; ++i) {
+    tt.store(7 + i * stride, PackedMove{}, 0, static_cast<int>(i + 1), Bound::Exact, &stats);
+  }
+  EXPECT_EQ(stats.stores, 5u);
+  EXPECT_EQ(stats.overwrites, 1u);
+
+  TTEntry entry;
+  EXPECT_FALSE(tt.probe(7, entry, &stats));
+  EXPECT_TRUE(tt.probe(7 + 4 * stride, entry, &stats));
+  EXPECT_FALSE(tt.probe(8, entry, &stats));
+  EXPECT_EQ(stats.probes, 3u);
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.collisions, 1u);
+}
+
+TEST(TranspositionTableTest, OlderGenerationIsReplacedFirst) {
+  TranspositionTable tt(1);
+  const uint64_t stride = tt.entry_count() / TranspositionTable::bucket_size;
+  tt.store(3, PackedMove{}, 0, 5, Bound::Exact);
+  tt.new_search();
+  for (uint64_t i = 1; i <= TranspositionTable::bucket_size; ++i) {
+    tt.store(3 + i * stride, PackedMove{}, 0, 2, Bound::Exact);
+  }
+  TTEntry entry;
+  EXPECT_FALSE(tt.probe(3, entry));
+  EXPECT_GT(tt.hashfull(), 0);
+}
+
+TEST(TranspositionTableTest, ConcurrentAccessNeverReturnsTornEntries) {
+  TranspositionTable tt(1);
+  // Every writer stores data derived from the key, so a verified hit must match it
+  auto score_of = [](uint64_t key) { return static_cast<int>(key % 20000) - 10000; };
+  auto depth_of = [](uint64_t key) { return static_cast<int>(key >> 60); };
+  std::atomic<int> bad{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      uint64_t x = 0x9E3779B97F4A7C15ULL * (t + 1);
+      for (int i = 0; i < 200000; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        // A small key space so threads keep hitting the same buckets
+        const uint64_t key = (x & 0xF0000000000000FFULL) | 1;
+        TTEntry entry;
+        if (tt.probe(key, entry) && (entry.score != score_of(key) || entry.depth != depth_of(key))) {
+          bad++;
+        }
+        tt.store(key, PackedMove{}, score_of(key), depth_of(key), Bound::Exact);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(bad.load(), 0);
+}
+
+TEST(TranspositionTableTest, SearchWithTableAgreesAndVisitsFewerNodes) {
+  ChessGame game("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3");
+  SearchLimits limits;
+  limits.depth = 5;
+  const SearchResult plain = Search(game).run(limits);
+
+  TranspositionTable tt(16);
+  Search search(game, &tt);
+  const SearchResult cached = search.run(limits);
+  EXPECT_EQ(cached.depth, 5);
+  EXPECT_LT(cached.nodes, plain.nodes);
+  EXPECT_GT(search.tt_stats().hits, 0u);
+
+  ChessGame mate("2r3k1/5ppp/8/8/8/8/3Q1PPP/3R2K1 w - - 0 1");
+  limits.depth = 6;
+  const SearchResult mated = Search(mate, &tt).run(limits);
+  EXPECT_EQ(mated.best_move.to_string(), "d2d8");
+  EXPECT_EQ(mated.score, Search::mate_score - 3);
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <Uci.h>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+namespace {
+  std::vector<std::string> lines(const std::string& output) {
+    std::vector<std::string> result;
+    std::istringstream stream(output);
+    for (std::string line; std::getline(stream, line);) {
+      result.push_back(line);
+    }
+    return result;
+  }
+
+  bool starts_with(const std::string& s, const std::string& prefix) {
+    return s.rfind(prefix, 0) == 0;
+  }
+}
+
+TEST(UciTest, Handshake) {
+  std::istringstream in("uci\nisready\nquit\n");
+  std::ostringstream out;
+  UciEngine engine(in, out);
+  engine.loop();
+  const auto output = lines(out.str());
+  ASSERT_GE(output.size(), 3u);
+  EXPECT_TRUE(starts_with(output.front(), "id name"));
+  EXPECT_EQ(output[output.size() - 2], "uciok");
+  EXPECT_EQ(output.back(), "readyok");
+}
+
+TEST(UciTest, GoDepthFindsMate) {
+  std::istringstream in;
+  std::ostringstream out;
+  UciEngine engine(in, out);
+  engine.execute("position fen 2r3k1/5ppp/8/8/8/8/3Q1PPP/3R2K1 w - - 0 1");
+  engine.execute("go depth 4");
+  engine.wait_for_search();
+  const auto output = lines(out.str());
+  ASSERT_FALSE(output.empty());
+  EXPECT_TRUE(starts_with(output.back(), "bestmove d2d8")) << output.back();
+  EXPECT_NE(out.str().find("score mate 2"), std::string::npos) << out.str();
+}
+
+TEST(UciTest, PositionWithMoves) {
+  std::istringstream in;
+  std::ostringstream out;
+  UciEngine engine(in, out);
+  // After 1. e4 e5 2. Qh5 Nc6 3. Bc4 Nf6 the only good move is Qxf7 mate
+  engine.execute("position startpos moves e2e4 e7e5 d1h5 b8c6 f1c4 g8f6");
+  engine.execute("go depth 2");
+  engine.wait_for_search();
+  EXPECT_TRUE(starts_with(lines(out.str()).back(), "bestmove h5f7"));
+
+  // An illegal move is reported and the moves before it are kept
+  std::ostringstream out2;
+  UciEngine engine2(in, out2);
+  engine2.execute("position startpos moves e2e4 e2e4");
+  EXPECT_NE(out2.str().find("illegal move e2e4"), std::string::npos);
+}
+
+TEST(UciTest, StopEndsInfiniteSearch) {
+  std::istringstream in;
+  std::ostringstream out;
+  UciEngine engine(in, out);
+  engine.execute("setoption name Threads value 2");
+  engine.execute("position startpos");
+  engine.execute("go infinite");
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  // stop joins the search, so its bestmove is the last line and the only one
+  engine.execute("stop");
+  const auto output = lines(out.str());
+  ASSERT_FALSE(output.empty());
+  EXPECT_TRUE(starts_with(output.back(), "bestmove "));
+  EXPECT_EQ(std::count_if(output.begin(), output.end(), [](const std::string& line) {
+    return starts_with(line, "bestmove");
+  }), 1);
+}
+
+TEST(UciTest, StopRightAfterGoIsNotLost) {
+  std::istringstream in;
+  std::ostringstream out;
+  UciEngine engine(in, out);
+  for (int i = 0; i < 20; ++i) {
+    engine.execute("go infinite");
+    engine.execute("stop");
+  }
+  size_t count = 0;
+  for (const auto& line : lines(out.str())) {
+    count += starts_with(line, "bestmove");
+  }
+  EXPECT_EQ(count, 20u);
+}
+
+TEST(UciTest, Perft) {
+  std::istringstream in;
+  std::ostringstream out;
+  UciEngine engine(in, out);
+  engine.execute("position fen r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+  engine.execute("go perft 3");
+  const auto output = lines(out.str());
+  EXPECT_EQ(output.back(), "Nodes searched: 97862");
+  EXPECT_EQ(output.size(), 48u + 2u);
+}
+
+TEST(UciTest, ClockSetsMoveTime) {
+  std::istringstream in;
+  std::ostringstream out;
+  UciEngine engine(in, out);
+  engine.execute("position startpos");
+  const auto start = std::chrono::steady_clock::now();
+  engine.execute("go wtime 3000 btime 3000 movestogo 10");
+  engine.wait_for_search();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(1000));
+  EXPECT_TRUE(starts_with(lines(out.str()).back(), "bestmove "));
+}
+
+TEST(UciTest, BadInputIsReported) {
+  std::istringstream in;
+  std::ostringstream out;
+  UciEngine engine(in, out);
+  engine.execute("setoption name EvalFile value /nonexistent/net.bin");
+  engine.execute("setoption name BookFile value /nonexistent/book.bin");
+  engine.execute("frobnicate");
+  engine.execute("position fen 8/8/8/8/8/8/8/8 x - - 0 1");
+  const std::string s = out.str();
+  EXPECT_NE(s.find("info string cannot set evalfile"), std::string::npos) << s;
+  EXPECT_NE(s.find("info string cannot set bookfile"), std::string::npos) << s;
+  EXPECT_NE(s.find("unknown command frobnicate"), std::string::npos);
+  EXPECT_NE(s.find("invalid fen"), std::string::npos);
+
+  // Positions the search cannot play are refused and the previous game kept
+  std::ostringstream out2;
+  UciEngine engine2(in, out2);
+  engine2.execute("position fen 6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+  for (const char* fen : {"8/8/8/8/8/8/8/8 w - - 0 1", "4k3/8/8/8/8/8/8/8 w - - 0 1", "4k3/8/8/8/8/8/8/4KK2 w - - 0 1",
+                          "4k3/8/8/8/8/8/8/4R1K1 w - - 0 1"}) {
+    engine2.execute(std::string("position fen ") + fen);
+    EXPECT_NE(out2.str().find(std::string("info string invalid fen ") + fen), std::string::npos) << fen;
+  }
+  engine2.execute("go depth 3");
+  engine2.wait_for_search();
+  EXPECT_TRUE(starts_with(lines(out2.str()).back(), "bestmove a1a8")) << out2.str();
+}
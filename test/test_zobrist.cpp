@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <ChessGame.h>
+
+static PackedMove find_move(ChessGame& game, const std::string& uci) {
+  MoveList moves;
+  game.generate_legal_moves(moves);
+  for (const auto m : moves) {
+    if (m.to_string() == uci) {
+      return m;
+    }
+  }
+  ADD_FAILURE() << "no legal move " << uci;
+  return {};
+}
+
+static void play(ChessGame& game, std::initializer_list<std::string> line) {
+  for (const auto& uci : line) {
+    game.apply_move(find_move(game, uci));
+  }
+}
+
+static void walk(ChessGame& game, int depth) {
+  ASSERT_EQ(game.key(), game.compute_key());
+  if (depth == 0) {
+    return;
+  }
+  MoveList moves;
+  game.generate_legal_moves(moves);
+  for (const auto m : moves) {
+    game.apply_move(m);
+    walk(game, depth - 1);
+    game.undo_move();
+    ASSERT_EQ(game.key(), game.compute_key());
+  }
+}
+
+TEST(ZobristTest, FenAndDefaultConstructorsAgree) {
+  ChessGame start;
+  ChessGame from_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  EXPECT_EQ(start.key(), from_fen.key());
+}
+
+TEST(ZobristTest, TranspositionsShareAKey) {
+  ChessGame game;
+  const uint64_t start = game.key();
+  play(game, {"g1f3", "g8f6", "f3g1", "f6g8"});
+  EXPECT_EQ(game.key(), start);
+
+  play(game, {"e2e4"});
+  ChessGame after_e4("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+  EXPECT_EQ(game.key(), after_e4.key());
+}
+
+TEST(ZobristTest, SideCastlingAndEnPassantChangeTheKey) {
+  ChessGame white("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+  ChessGame black("r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1");
+  ChessGame no_castle("r3k2r/8/8/8/8/8/8/R3K2R w - - 0 1");
+  ChessGame en_passant("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+  ChessGame no_en_passant("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+  EXPECT_NE(white.key(), black.key());
+  EXPECT_NE(white.key(), no_castle.key());
+  EXPECT_NE(en_passant.key(), no_en_passant.key());
+}
+
+TEST(ZobristTest, CastlingAndUndoRestoreKey) {
+  ChessGame game("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+  const uint64_t before = game.key();
+  play(game, {"e1g1"});
+  ChessGame castled("r3k2r/8/8/8/8/8/8/R4RK1 b kq - 1 1");
+  EXPECT_EQ(game.key(), castled.key());
+  game.undo_move();
+  EXPECT_EQ(game.key(), before);
+}
+
+TEST(ZobristTest, IncrementalKeyMatchesRecomputation) {
+  ChessGame kiwipete("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+  walk(kiwipete, 3);
+  ChessGame promotions("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8");
+  walk(promotions, 3);
+}
@@ -0,0 +1,107 @@
+//
+// Generates distance to mate tablebases for three and four piece endings. Tables
+// already in the output directory are reused, so an interrupted run picks up where it
+// stopped. Progress is reported on stderr.
+//
+// usage: tb_generate [--threads N] [--output DIR] [--force] [SIGNATURE...]
+//
+// Without signatures every table is generated. Named tables need the tables their
+// captures and promotions lead to, which must already be in the output directory.
+//
+
+#include <Tablebase.h>
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+  constexpr std::string_view usage = "usage: tb_generate [--threads N] [--output DIR] [--force] [SIGNATURE...]\n";
+
+  struct Options {
+    size_t threads{1};
+    std::string output{"."};
+    bool force{false};
+    std::vector<std::string> signatures;
+  };
+
+  // Leaves value alone unless all of s is a number that fits
+  template <typename T>
+  bool parse_number(std::string_view s, T& value) {
+    T parsed{};
+    const auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), parsed);
+    if (s.empty() || ec != std::errc{} || ptr != s.data() + s.size()) {
+      return false;
+    }
+    value = parsed;
+    return true;
+  }
+
+  bool parse_args(int argc, char** argv, Options& opts) {
+    opts.threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i) {
+      const std::string_view arg = argv[i];
+      if (arg == "--force") {
+        opts.force = true;
+        continue;
+      }
+      if (!arg.starts_with("--")) {
+        opts.signatures.emplace_back(arg);
+        continue;
+      }
+      if (i + 1 >= argc) {
+        std::cerr << "missing value for " << arg << "\n";
+        return false;
+      }
+      const std::string value = argv[++i];
+      if (arg == "--threads") {
+        if (!parse_number(value, opts.threads)) {
+          std::cerr << "invalid thread count " << value << "\n";
+          return false;
+        }
+        opts.threads = std::max<size_t>(1, opts.threads);
+      } else if (arg == "--output") {
+        opts.output = value;
+      } else {
+        std::cerr << "unknown option " << arg << "\n";
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+int main(int argc, char** argv) {
+  Options opts;
+  if (!parse_args(argc, argv, opts)) {
+    std::cerr << usage;
+    return 2;
+  }
+  if (opts.signatures.empty()) {
+    opts.signatures = Tablebase::all_signatures();
+  }
+
+  try {
+    std::filesystem::create_directories(opts.output);
+    Tablebase::Tablebases tables;
+    tables.load_directory(opts.output);
+    for (const std::string& signature : opts.signatures) {
+      if (tables.contains(signature) && !opts.force) {
+        std::cerr << signature << ": already generated\n";
+        continue;
+      }
+      const auto stats = Tablebase::generate(signature, opts.output, tables, opts.threads);
+      std::cerr << std::format("{}: {} positions, {} wins, {} draws, {} losses, longest mate {} plies, {:.1f} s\n",
+        signature, stats.positions, stats.wins, stats.draws, stats.losses, stats.longest_mate, stats.elapsed.count());
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}